@@ -0,0 +1,650 @@
+// Headless batch runner: times ingestion, order book replay and analytics without SDL or OpenGL
+// and prints a JSON report, for performance regression runs on machines without a display.
+//
+// TradingHeadless [--data file.csv] [--run load,indicators,correlation,book,depth,tape,risk,iceberg,soak,screen,backtest,compress]
+//                 [--threads N] [--repeat N] [--orders N] [--allocator system|monotonic|pool]
+//                 [--seconds N] [--producers N] [--books N] [--rate N] [--walk random|revert|jumpy]
+//                 [--pages default|transparent|explicit] [--numa] [--prefault] [--reserve N]
+//                 [--report out.json]
+//
+// soak runs once whatever --repeat says, for --seconds with --producers threads sending --rate orders
+// a second each into --books shared books, and prints a line per second as it goes
+//
+// --pages, --numa and --prefault place every tag's large blocks, --reserve sizes the book and soak
+// books for that many orders up front; the report's memory section says where the blocks ended up
+#include "Backtest.h"
+#include "Correlation.h"
+#include "CsvLoader.h"
+#include "DepthHistory.h"
+#include "Indicators.h"
+#include "LoadGenerator.h"
+#include "MarketData.h"
+#include "Memory.h"
+#include "Orderbook.h"
+#include "Placement.h"
+#include "Screener.h"
+#include "TradeTape.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		std::string dataFile{ "TradingApp/data/all_stocks_5yr.csv" };
+		std::vector<std::string> workloads{ "load", "indicators", "correlation", "book", "backtest" };
+		unsigned threads{ 0 };
+		unsigned repeat{ 3 };
+		size_t orders{ 1000000 };
+		AllocatorKind allocator{ AllocatorKind::Pool }; // for the book workload
+		PlacementConfig placement;                      // of every tag
+		size_t reserve{};                               // orders per book, for book and soak
+		LoadConfig soak;
+		std::string reportFile; // stdout when empty
+	};
+
+	struct WorkloadReport
+	{
+		std::string name;
+		std::string unit;   // what items counts
+		uint64_t items{};   // per run
+		uint64_t bytes{};   // per run, 0 when not meaningful
+		std::vector<double> seconds;
+		std::string detail; // extra JSON members of the workload, empty when none
+	};
+
+	std::vector<std::string> Split(const char* list)
+	{
+		std::vector<std::string> parts;
+		std::string part;
+		for (const char* c = list; ; ++c)
+		{
+			if (*c == ',' || *c == '\0')
+			{
+				if (part.empty() == false)
+					parts.push_back(part);
+				part.clear();
+				if (*c == '\0')
+					break;
+			}
+			else
+			{
+				part.push_back(*c);
+			}
+		}
+		return parts;
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& outOptions)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const bool hasValue = i + 1 < argc;
+			if (std::strcmp(argv[i], "--data") == 0 && hasValue)
+				outOptions.dataFile = argv[++i];
+			else if (std::strcmp(argv[i], "--run") == 0 && hasValue)
+				outOptions.workloads = Split(argv[++i]);
+			else if (std::strcmp(argv[i], "--threads") == 0 && hasValue)
+				outOptions.threads = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+			else if (std::strcmp(argv[i], "--repeat") == 0 && hasValue)
+				outOptions.repeat = std::max(1u, (unsigned)std::strtoul(argv[++i], nullptr, 10));
+			else if (std::strcmp(argv[i], "--orders") == 0 && hasValue)
+				outOptions.orders = (size_t)std::strtoull(argv[++i], nullptr, 10);
+			else if (std::strcmp(argv[i], "--allocator") == 0 && hasValue)
+			{
+				const char* kind = argv[++i];
+				if (std::strcmp(kind, "system") == 0)
+					outOptions.allocator = AllocatorKind::System;
+				else if (std::strcmp(kind, "monotonic") == 0)
+					outOptions.allocator = AllocatorKind::Monotonic;
+				else if (std::strcmp(kind, "pool") == 0)
+					outOptions.allocator = AllocatorKind::Pool;
+				else
+				{
+					std::fprintf(stderr, "Unknown allocator %s\n", kind);
+					return false;
+				}
+			}
+			else if (std::strcmp(argv[i], "--seconds") == 0 && hasValue)
+				outOptions.soak.seconds = std::strtod(argv[++i], nullptr);
+			else if (std::strcmp(argv[i], "--producers") == 0 && hasValue)
+				outOptions.soak.producers = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+			else if (std::strcmp(argv[i], "--books") == 0 && hasValue)
+				outOptions.soak.books = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+			else if (std::strcmp(argv[i], "--rate") == 0 && hasValue)
+				outOptions.soak.ordersPerSecond = std::strtod(argv[++i], nullptr);
+			else if (std::strcmp(argv[i], "--walk") == 0 && hasValue)
+			{
+				const char* walk = argv[++i];
+				if (std::strcmp(walk, "random") == 0)
+					outOptions.soak.walk = PriceWalk::Random;
+				else if (std::strcmp(walk, "revert") == 0)
+					outOptions.soak.walk = PriceWalk::MeanReverting;
+				else if (std::strcmp(walk, "jumpy") == 0)
+					outOptions.soak.walk = PriceWalk::Jumpy;
+				else
+				{
+					std::fprintf(stderr, "Unknown walk %s\n", walk);
+					return false;
+				}
+			}
+			else if (std::strcmp(argv[i], "--pages") == 0 && hasValue)
+			{
+				const char* pages = argv[++i];
+				if (Memory::ParsePagePolicy(pages, outOptions.placement.pages) == false)
+				{
+					std::fprintf(stderr, "Unknown page policy %s\n", pages);
+					return false;
+				}
+			}
+			else if (std::strcmp(argv[i], "--numa") == 0)
+				outOptions.placement.localNode = true;
+			else if (std::strcmp(argv[i], "--prefault") == 0)
+				outOptions.placement.prefault = true;
+			else if (std::strcmp(argv[i], "--reserve") == 0 && hasValue)
+			{
+				outOptions.reserve = (size_t)std::strtoull(argv[++i], nullptr, 10);
+				outOptions.soak.reserveOrders = outOptions.reserve;
+			}
+			else if (std::strcmp(argv[i], "--report") == 0 && hasValue)
+				outOptions.reportFile = argv[++i];
+			else
+			{
+				std::fprintf(stderr, "Unknown argument %s\n", argv[i]);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	double Seconds(const std::function<void()>& fn)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		fn();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	uint64_t TotalRows(const MarketData& data)
+	{
+		uint64_t rows = 0;
+		for (size_t i = 0; i < data.Count(); ++i)
+		{
+			rows += data.Get((SymbolID)i).size();
+		}
+		return rows;
+	}
+
+	// deterministic mix of resting limit orders, cancels and aggressive FillAndKill orders around a drifting mid,
+	// with history the book's depth is sampled after every order, with tape every fill is recorded
+	// as if orders arrived a millisecond apart, with accounts orders are spread over that many limited accounts
+	uint64_t ReplayOrderFlow(size_t count, AllocatorKind allocator, DepthHistory* history = nullptr, TradeTape* tape = nullptr, size_t accounts = 0, OrderBook* outBook = nullptr, size_t reserve = 0)
+	{
+		// only built when the caller does not pass a book in
+		std::unique_ptr<OrderBook> ownBook;
+		if (outBook == nullptr)
+			ownBook = std::make_unique<OrderBook>(OrderBookMode::SingleThreaded, allocator);
+		OrderBook& book = outBook ? *outBook : *ownBook;
+		if (reserve)
+			book.Reserve(reserve);
+		std::mt19937_64 rng(42);
+		std::vector<OrderID> live;
+		live.reserve(count);
+
+		Price mid = 10000;
+		RiskLimits limits;
+		limits.maxOrderQuantity = 95;
+		limits.priceBand = 150;
+		limits.maxOpenNotional = 500'000'000;
+		limits.maxPosition = 20'000;
+		for (size_t account = 1; account <= accounts; ++account)
+			book.SetRiskLimits((AccountID)account, limits);
+		if (accounts)
+			book.SetReferencePrice(mid);
+		uint64_t trades = 0;
+		for (OrderID id = 1; id <= count; ++id)
+		{
+			const uint64_t r = rng();
+			const Side side = (r & 1) ? Side::Buy : Side::Sell;
+			const Quantity quantity = (Quantity)(1 + (r >> 8) % 100);
+			const Price offset = (Price)((r >> 16) % 50);
+			const AccountID account = accounts ? (AccountID)(1 + id % accounts) : 0;
+			mid += (Price)((r >> 24) % 3) - 1;
+
+			Trades fills;
+			switch ((r >> 32) % 10)
+			{
+			case 0:
+			case 1:
+				if (live.empty() == false)
+				{
+					const size_t at = (size_t)((r >> 40) % live.size());
+					book.CancelOrder(live[at]);
+					live[at] = live.back();
+					live.pop_back();
+					break;
+				}
+				[[fallthrough]];
+			case 2:
+				fills = book.AddOrder(book.CreateOrder(OrderType::FillAndKill, id, side, side == Side::Buy ? mid + offset : mid - offset, quantity, account));
+				break;
+			default:
+				fills = book.AddOrder(book.CreateOrder(OrderType::GoodTillCancel, id, side, side == Side::Buy ? mid - offset - 1 : mid + offset + 1, quantity, account));
+				live.push_back(id);
+				break;
+			}
+			trades += fills.size();
+			if (tape)
+				tape->Append(id * 0.001, fills, side);
+
+			if (history)
+				history->Sample(id, book);
+		}
+		return trades;
+	}
+
+	// one maker works parents of 1000 at a single price against takers of 1 to 20, showing 50 at a time,
+	// either as native icebergs or by entering a new 50 lot each time the last one filled.
+	// returns how many orders the maker entered
+	uint64_t ReplayIcebergs(size_t parents, AllocatorKind allocator, bool native)
+	{
+		constexpr Quantity PARENT = 1000;
+		constexpr Quantity SLICE = 50;
+		constexpr Price PRICE = 10000;
+
+		OrderBook book(OrderBookMode::SingleThreaded, allocator);
+		std::mt19937_64 rng(7);
+		OrderID nextID = 1;
+		uint64_t entered = 0;
+
+		for (size_t parent = 0; parent < parents; ++parent)
+		{
+			Quantity unsent = PARENT;
+			Quantity showing = 0;
+			OrderID makerID = 0;
+			auto enter = [&] {
+				makerID = nextID++;
+				showing = native ? unsent : std::min(SLICE, unsent);
+				unsent -= showing;
+				book.AddOrder(native ? book.CreateIceberg(makerID, Side::Sell, PRICE, showing, SLICE) : book.CreateOrder(OrderType::GoodTillCancel, makerID, Side::Sell, PRICE, showing));
+				++entered;
+			};
+			enter();
+
+			while (showing > 0)
+			{
+				const Quantity quantity = (Quantity)(1 + rng() % 20);
+				for (const Trade& trade : book.AddOrder(book.CreateOrder(OrderType::FillAndKill, nextID++, Side::Buy, PRICE, quantity)))
+				{
+					if (trade.askTrade.orderID == makerID)
+						showing -= trade.askTrade.quantity;
+				}
+				if (showing == 0 && unsent > 0)
+					enter();
+			}
+		}
+		return entered;
+	}
+
+	void AppendJsonString(std::string& out, const std::string& text)
+	{
+		out.push_back('"');
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				out.push_back('\\');
+			out.push_back(c);
+		}
+		out.push_back('"');
+	}
+
+	std::string FormatReport(const Options& options, unsigned threads, const std::vector<WorkloadReport>& reports)
+	{
+		char number[64];
+		std::string out = "{\n  \"data\": ";
+		AppendJsonString(out, options.dataFile);
+		std::snprintf(number, sizeof(number), ",\n  \"threads\": %u,\n  \"repeat\": %u,", threads, options.repeat);
+		out += number;
+		constexpr const char* pageNames[] = { "default", "transparent", "explicit" };
+		out += "\n  \"pages\": ";
+		AppendJsonString(out, pageNames[(size_t)options.placement.pages]);
+		std::snprintf(number, sizeof(number), ", \"numa\": %s, \"prefault\": %s, \"nodes\": %u,",
+			options.placement.localNode ? "true" : "false", options.placement.prefault ? "true" : "false", Memory::NodeCount());
+		out += number;
+		out += "\n  \"workloads\": [";
+
+		for (size_t w = 0; w < reports.size(); ++w)
+		{
+			const WorkloadReport& report = reports[w];
+			std::vector<double> sorted = report.seconds;
+			std::sort(sorted.begin(), sorted.end());
+			const double best = sorted.front();
+			const double median = sorted[sorted.size() / 2];
+
+			out += w == 0 ? "\n    {\"name\": " : ",\n    {\"name\": ";
+			AppendJsonString(out, report.name);
+			out += ", \"unit\": ";
+			AppendJsonString(out, report.unit);
+			std::snprintf(number, sizeof(number), ", \"items\": %llu", (unsigned long long)report.items);
+			out += number;
+			std::snprintf(number, sizeof(number), ", \"bytes\": %llu", (unsigned long long)report.bytes);
+			out += number;
+			std::snprintf(number, sizeof(number), ", \"bestSeconds\": %.6f", best);
+			out += number;
+			std::snprintf(number, sizeof(number), ", \"medianSeconds\": %.6f", median);
+			out += number;
+			std::snprintf(number, sizeof(number), ", \"itemsPerSecond\": %.1f", best > 0.0 ? report.items / best : 0.0);
+			out += number;
+			std::snprintf(number, sizeof(number), ", \"megabytesPerSecond\": %.1f", best > 0.0 ? report.bytes / best / (1024.0 * 1024.0) : 0.0);
+			out += number;
+			out += ", \"seconds\": [";
+			for (size_t i = 0; i < report.seconds.size(); ++i)
+			{
+				std::snprintf(number, sizeof(number), i == 0 ? "%.6f" : ", %.6f", report.seconds[i]);
+				out += number;
+			}
+			out += "]";
+			out += report.detail;
+			out += "}";
+		}
+
+		// whole process, peaks include every workload that ran before
+		out += "\n  ],\n  \"memory\": [";
+		for (size_t t = 0; t < (size_t)MemoryTag::Count; ++t)
+		{
+			const MemoryTag tag = (MemoryTag)t;
+			const MemoryStats stats = Memory::Stats(tag);
+			out += t == 0 ? "\n    {\"tag\": " : ",\n    {\"tag\": ";
+			AppendJsonString(out, Memory::TagName(tag));
+			std::snprintf(number, sizeof(number), ", \"liveBytes\": %llu", (unsigned long long)stats.liveBytes);
+			out += number;
+			std::snprintf(number, sizeof(number), ", \"peakBytes\": %llu", (unsigned long long)stats.peakBytes);
+			out += number;
+			std::snprintf(number, sizeof(number), ", \"allocations\": %llu", (unsigned long long)stats.allocations);
+			out += number;
+
+			// where the kernel put the blocks the placement layer mapped, all zero under the default policy
+			const PlacementStats placement = Memory::Placement(tag);
+			std::snprintf(number, sizeof(number), ", \"mappedBytes\": %llu", (unsigned long long)placement.mappedBytes);
+			out += number;
+			std::snprintf(number, sizeof(number), ", \"hugeBytes\": %llu", (unsigned long long)placement.hugeBytes);
+			out += number;
+			out += ", \"nodeBytes\": [";
+			const size_t nodes = std::min<size_t>(Memory::NodeCount(), PlacementStats::MAX_NODES);
+			for (size_t node = 0; node < nodes; ++node)
+			{
+				std::snprintf(number, sizeof(number), node == 0 ? "%llu" : ", %llu", (unsigned long long)placement.nodeBytes[node]);
+				out += number;
+			}
+			std::snprintf(number, sizeof(number), "], \"otherBytes\": %llu}", (unsigned long long)placement.otherBytes);
+			out += number;
+		}
+		out += "\n  ]\n}\n";
+		return out;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (ParseOptions(argc, argv, options) == false)
+		return 2;
+	// before any workload maps memory, the policy only applies to blocks mapped after it is set
+	for (size_t t = 0; t < (size_t)MemoryTag::Count; ++t)
+		Memory::SetPlacement((MemoryTag)t, options.placement);
+
+	const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+	std::vector<WorkloadReport> reports;
+
+	std::error_code error;
+	const uint64_t fileBytes = std::filesystem::file_size(options.dataFile, error);
+
+	// analytics need the market loaded once even when load itself is not measured
+	std::unique_ptr<MarketData> market;
+	auto load = [&] {
+		market = std::make_unique<MarketData>();
+		return LoadCsv(options.dataFile.c_str(), *market, threads);
+	};
+
+	for (const std::string& name : options.workloads)
+	{
+		WorkloadReport report;
+		report.name = name;
+
+		// order book workloads make up their own flow
+		const bool bookOnly = name == "book" || name == "depth" || name == "tape" || name == "risk" || name == "iceberg" || name == "soak";
+		if (name != "load" && bookOnly == false && market == nullptr && load() == false)
+		{
+			std::fprintf(stderr, "Cannot load %s\n", options.dataFile.c_str());
+			return 1;
+		}
+
+		for (unsigned run = 0; run < options.repeat; ++run)
+		{
+			if (name == "load")
+			{
+				bool loaded = false;
+				report.seconds.push_back(Seconds([&] { loaded = load(); }));
+				if (loaded == false)
+				{
+					std::fprintf(stderr, "Cannot load %s\n", options.dataFile.c_str());
+					return 1;
+				}
+				report.unit = "rows";
+				report.items = TotalRows(*market);
+				report.bytes = error ? 0 : fileBytes;
+			}
+			else if (name == "indicators")
+			{
+				// a fresh cache per run, so every run computes full series instead of appending
+				const IndicatorSpec specs[] = {
+					{ IndicatorType::SMA, 20 }, { IndicatorType::EMA, 20 }, { IndicatorType::VWAP, 20 },
+					{ IndicatorType::Bollinger, 20 }, { IndicatorType::RSI, 14 }, { IndicatorType::ATR, 14 },
+					{ IndicatorType::RollingMin, 20 }, { IndicatorType::RollingMax, 20 } };
+				IndicatorCache cache;
+				report.seconds.push_back(Seconds([&] {
+					for (const IndicatorSpec& spec : specs)
+						cache.UpdateAll(*market, spec, threads);
+				}));
+				report.unit = "rows";
+				report.items = TotalRows(*market) * std::size(specs);
+			}
+			else if (name == "correlation")
+			{
+				CorrelationMatrix correlation;
+				report.seconds.push_back(Seconds([&] {
+					correlation.Build(*market);
+					correlation.SetWindow(0, correlation.Days(), threads);
+				}));
+				report.unit = "symbol pair days";
+				report.items = (uint64_t)correlation.Symbols() * correlation.Symbols() * correlation.Days();
+			}
+			else if (name == "book")
+			{
+				uint64_t trades = 0;
+				report.seconds.push_back(Seconds([&] { trades = ReplayOrderFlow(options.orders, options.allocator, nullptr, nullptr, 0, nullptr, options.reserve); }));
+				report.unit = "orders";
+				report.items = options.orders;
+				std::fprintf(stderr, "book matched %llu trades\n", (unsigned long long)trades);
+			}
+			else if (name == "depth")
+			{
+				// the book workload plus a depth sample per order, the difference is the recording cost
+				DepthHistory history;
+				report.seconds.push_back(Seconds([&] { ReplayOrderFlow(options.orders, options.allocator, &history); }));
+				report.unit = "orders";
+				report.items = options.orders;
+				std::fprintf(stderr, "depth kept %zu of %llu snapshots\n", history.Size(), (unsigned long long)history.Recorded());
+			}
+			else if (name == "tape")
+			{
+				// the book workload plus recording every fill and rolling it into bars
+				TradeTape tape;
+				report.seconds.push_back(Seconds([&] { tape.Clear(); ReplayOrderFlow(options.orders, options.allocator, nullptr, &tape); }));
+				report.unit = "orders";
+				report.items = options.orders;
+				std::fprintf(stderr, "tape recorded %zu trades into %zu bars of %gs\n", tape.Size(), tape.Bars(0).size(), tape.IntervalSeconds(0));
+			}
+			else if (name == "risk")
+			{
+				// the book workload with every order checked against one of 64 limited accounts
+				constexpr size_t accounts = 64;
+				uint64_t rejects[(size_t)RiskReject::Count]{};
+				report.seconds.push_back(Seconds([&] {
+					OrderBook book(OrderBookMode::SingleThreaded, options.allocator);
+					ReplayOrderFlow(options.orders, options.allocator, nullptr, nullptr, accounts, &book);
+					for (size_t reason = 0; reason < (size_t)RiskReject::Count; ++reason)
+						rejects[reason] = book.RiskRejects((RiskReject)reason);
+				}));
+				report.unit = "orders";
+				report.items = options.orders;
+				for (size_t reason = 1; reason < (size_t)RiskReject::Count; ++reason)
+					std::fprintf(stderr, "risk rejected %llu orders for %s\n", (unsigned long long)rejects[reason], PreTradeRisk::RejectName((RiskReject)reason));
+			}
+			else if (name == "iceberg")
+			{
+				// times native icebergs, the sliced run is the client side replenishment they replace
+				const size_t parents = std::max<size_t>(options.orders / 100, 1);
+				uint64_t native = 0, sliced = 0;
+				report.seconds.push_back(Seconds([&] { native = ReplayIcebergs(parents, options.allocator, true); }));
+				const double slicedSeconds = Seconds([&] { sliced = ReplayIcebergs(parents, options.allocator, false); });
+				report.unit = "parent orders";
+				report.items = parents;
+				std::fprintf(stderr, "iceberg maker entered %llu orders, %llu when slicing itself (%.3f s)\n",
+					(unsigned long long)native, (unsigned long long)sliced, slicedSeconds);
+			}
+			else if (name == "soak")
+			{
+				LoadConfig config = options.soak;
+				config.allocator = options.allocator;
+				std::fprintf(stderr, "soak %u producers, %u books, %.0f orders/s each, %.0f s\n", config.producers, config.books, config.ordersPerSecond, config.seconds);
+				std::fprintf(stderr, "%8s %10s %10s %8s %8s %8s %10s %9s %9s %9s\n", "seconds", "orders/s", "trades", "p50 ns", "p99 ns", "p999 ns", "max ns", "book MB", "resting", "contended");
+
+				// timed by the run itself, closing the shared books afterwards takes a few seconds
+				// where the live books sit, taken while they still exist; the memory section is of the end of the process
+				PlacementStats placed[2];
+				const LoadReport load = RunLoad(config, [&placed](const LoadSample& sample) {
+					placed[0] = Memory::Placement(MemoryTag::OrderBook);
+					placed[1] = Memory::Placement(MemoryTag::Orders);
+					std::fprintf(stderr, "%8.1f %10.0f %10llu %8llu %8llu %8llu %10llu %9.1f %9llu %8.2f%%\n", sample.seconds, sample.ordersPerSecond,
+						(unsigned long long)sample.trades, (unsigned long long)sample.p50, (unsigned long long)sample.p99, (unsigned long long)sample.p999,
+						(unsigned long long)sample.maximum, sample.bookBytes / (1024.0 * 1024.0), (unsigned long long)sample.restingOrders, sample.contendedShare * 100.0);
+				});
+				report.seconds.push_back(load.seconds);
+				report.unit = "orders";
+				report.items = load.orders;
+
+				char number[256];
+				std::snprintf(number, sizeof(number), ", \"trades\": %llu, \"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"lockContended\": %llu, \"lockWaitNanoseconds\": %llu, \"samples\": [",
+					(unsigned long long)load.trades, (unsigned long long)load.latency.Percentile(0.5), (unsigned long long)load.latency.Percentile(0.99),
+					(unsigned long long)load.latency.Percentile(0.999), (unsigned long long)load.lock.contended, (unsigned long long)load.lock.waitNanoseconds);
+				report.detail = number;
+				for (size_t i = 0; i < load.samples.size(); ++i)
+				{
+					const LoadSample& sample = load.samples[i];
+					std::snprintf(number, sizeof(number), "%s\n      {\"seconds\": %.2f, \"ordersPerSecond\": %.1f, \"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu, \"bookBytes\": %llu, \"resting\": %llu, \"contendedShare\": %.4f}",
+						i == 0 ? "" : ",", sample.seconds, sample.ordersPerSecond, (unsigned long long)sample.p50, (unsigned long long)sample.p99, (unsigned long long)sample.p999,
+						(unsigned long long)sample.maximum, (unsigned long long)sample.bookBytes, (unsigned long long)sample.restingOrders, sample.contendedShare);
+					report.detail += number;
+				}
+				report.detail += "]";
+
+				PlacementStats books;
+				for (const PlacementStats& stats : placed)
+				{
+					books.blocks += stats.blocks;
+					books.mappedBytes += stats.mappedBytes;
+					books.hugeBytes += stats.hugeBytes;
+					books.otherBytes += stats.otherBytes;
+					for (size_t node = 0; node < PlacementStats::MAX_NODES; ++node)
+						books.nodeBytes[node] += stats.nodeBytes[node];
+				}
+				std::snprintf(number, sizeof(number), ", \"placedBytes\": %llu, \"hugeBytes\": %llu, \"nodeBytes\": [",
+					(unsigned long long)books.mappedBytes, (unsigned long long)books.hugeBytes);
+				report.detail += number;
+				const size_t nodes = std::min<size_t>(Memory::NodeCount(), PlacementStats::MAX_NODES);
+				for (size_t node = 0; node < nodes; ++node)
+				{
+					std::snprintf(number, sizeof(number), node == 0 ? "%llu" : ", %llu", (unsigned long long)books.nodeBytes[node]);
+					report.detail += number;
+				}
+				report.detail += "]";
+				std::fprintf(stderr, "soak books held %.1f MB in %zu placed blocks, %.1f MB on huge pages\n",
+					books.mappedBytes / (1024.0 * 1024.0), books.blocks, books.hugeBytes / (1024.0 * 1024.0));
+			}
+			else if (name == "screen")
+			{
+				// the date index, then every day screened for symbols over their 200 row high, best movers first
+				DateIndex index;
+				ScreenQuery query;
+				query.conditions.push_back(ScreenCondition{ ScreenField::VsHigh, ScreenCompare::Above, 0.0, 200 });
+				query.limit = 10;
+				std::vector<ScreenHit> hits;
+				double buildSeconds = 0.0, lastDaySeconds = 0.0;
+				report.seconds.push_back(Seconds([&] {
+					buildSeconds = Seconds([&] { index.Build(*market); });
+					hits = Screener::RunRange(*market, index, 0, index.Days(), query, threads);
+				}));
+				lastDaySeconds = Seconds([&] { Screener::Run(*market, index, index.Days() - 1, query); });
+				report.unit = "days";
+				report.items = index.Days();
+				std::fprintf(stderr, "screen indexed %zu days in %.2f ms, %zu hits, one day in %.3f ms\n",
+					index.Days(), buildSeconds * 1000.0, hits.size(), lastDaySeconds * 1000.0);
+			}
+			else if (name == "compress")
+			{
+				// decompressing afterwards leaves owned columns for the workloads that follow
+				size_t packed = 0, raw = 0;
+				report.seconds.push_back(Seconds([&] { market->Compress(); }));
+				market->CompressedSize(packed, raw);
+				market->Decompress();
+				report.unit = "rows";
+				report.items = TotalRows(*market);
+				report.bytes = raw;
+				std::fprintf(stderr, "compressed %.1f MB to %.1f MB\n", raw / (1024.0 * 1024.0), packed / (1024.0 * 1024.0));
+			}
+			else if (name == "backtest")
+			{
+				BacktestSummary summary;
+				report.seconds.push_back(Seconds([&] { summary = RunBacktest(*market, BacktestConfig{}, threads); }));
+				report.unit = "bars";
+				report.items = TotalRows(*market);
+			}
+			else
+			{
+				std::fprintf(stderr, "Unknown workload %s\n", name.c_str());
+				return 2;
+			}
+			std::fprintf(stderr, "%s run %u: %.3f s\n", name.c_str(), run + 1, report.seconds.back());
+			if (name == "soak")
+				break;
+		}
+		reports.push_back(std::move(report));
+	}
+
+	const std::string json = FormatReport(options, threads, reports);
+	if (options.reportFile.empty())
+	{
+		std::fputs(json.c_str(), stdout);
+		return 0;
+	}
+
+	FILE* file = std::fopen(options.reportFile.c_str(), "wb");
+	if (file == nullptr)
+	{
+		std::fprintf(stderr, "Cannot write %s\n", options.reportFile.c_str());
+		return 1;
+	}
+	std::fputs(json.c_str(), file);
+	std::fclose(file);
+	return 0;
+}
@@ -1,54 +1,102 @@
 #pragma once
 
-#include <fstream>
 #include <unordered_map>
 #include <map>
 #include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include "imgui.h"
+#include "MarketData.h"
+#include "Placement.h"
+#include "MappedFile.h"
+#include "CsvLoader.h"
+#include "MarketDataBus.h"
+#include "DepthHistory.h"
+#include "TradeTape.h"
+#include "Indicators.h"
+#include "Correlation.h"
+#include "Screener.h"
+#include "FileFollower.h"
+#include "MarketFetcher.h"
+#include "Backtest.h"
 
-struct DataFrame
+struct FetchStatus
 {
-	double date{};
-	double open{};
-	double close{};
-	double high{};
-	double low{};
-	double volume{};
-
-	void Print();
+	size_t requested{};
+	size_t succeeded{};
+	size_t failed{};
+	uint64_t bytes{};
+	std::chrono::steady_clock::time_point start;
+	double seconds{};
 };
 
-struct DataStore
+enum class AppMode
 {
-	std::string name;
-	std::vector<double> date;
-	std::vector<double> open;
-	std::vector<double> close;
-	std::vector<double> high;
-	std::vector<double> low;
-	std::vector<double> volume;
-
-	double maximum{-DBL_MAX };
-	double minimum{ DBL_MAX };
-
-	void PushData(const DataFrame& df);
-	size_t size() { return date.size(); };
+	Default,
+	Engine,  // run the order book and publish to the market data bus
+	Viewer   // attach to the market data bus as a read-only consumer
 };
 
-
 class App
 {
 public:
+	void ParseArgs(int argc, char** argv);
 	void Run();
 
 private:
-	std::map<std::string, DataStore> dataMap;
-	std::vector<const char*> names;
+	AppMode mode{ AppMode::Default };
+	bool follow{ false }; // keep appending rows written to the data file after the load
+	PlacementConfig placement; // of every memory tag, set from the command line before anything big is allocated
+
+	MappedFile marketCache; // backs market columns when loaded from cache
+	MarketData market;
+	IndicatorCache indicators;
+	CorrelationMatrix correlation;
+	uint64_t marketVersion{}; // bumped whenever rows are appended
+	uint64_t correlationVersion{};
+	DateIndex dateIndex;
+	uint64_t dateIndexVersion{};
+
+	std::unique_ptr<MarketDataSubscriber> busSubscriber;
+	BusDepth busDepth{};
+	DepthHistory depthHistory{ BUS_DEPTH_LEVELS }; // every depth snapshot off the bus
+	std::deque<BusTrade> busTrades;
+	TradeTape tradeTape; // every fill off the bus, rolled into live bars
+
+	// market is filled in the background, the ui only reads what progress reports ready
+	LoadProgress loadProgress;
+	// fetched rows are merged on the ui thread like followed ones
+	FetchStatus fetchStatus;
+	// market is read only while a backtest runs, followed rows wait in the queue
+	BacktestSummary backtestSummary;
+	std::atomic<bool> backtestRunning{ false };
+
+	// everything that owns a thread comes last, so each is stopped and joined
+	// before any of the members above, which those threads write, is destroyed
+	FileFollower follower;
+	MarketFetcher fetcher;
+	std::jthread backtestThread;
+	std::jthread loadThread;
 
 	void ParseFile(const char *fileName);
-	bool ParseLine(std::fstream& file, DataFrame& outFrame, std::string& outName);
+	void ApplyFollowedRows();
+	void ApplyFetchedData();
+
+	void RunOrderBookDemo();
+	void RunEngine();
 
 	void ShowTraderWindow();
-	void PlotCandlestick(const char* label_id, const double* xs, const double* opens, const double* closes, const double* lows, const double* highs, int count, bool tooltip, float width_percent, ImVec4 bullCol, ImVec4 bearCol);
+	void ShowMarketDataWindow();
+	void ShowCorrelationWindow();
+	void ShowScreenerWindow();
+	void ShowBacktestWindow();
+	void ShowFetchWindow();
+	void ShowProfilerWindow();
+	void ShowMemoryWindow();
+	void PlotCompressedHistory(const DataStore& ds, bool tooltip);
+	void PlotCandlestick(const char* label_id, const DataStore& ds, bool tooltip, float width_percent, ImVec4 bullCol, ImVec4 bearCol);
 };
 
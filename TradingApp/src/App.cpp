@@ -2,6 +2,14 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <cstring>
+#include <csignal>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <ctime>
 
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
@@ -20,9 +28,37 @@
 #include <implot.h>
 #include <implot_internal.h>
 
-#include <curl/curl.h>
 
 #include "Orderbook.h"
+#include "CsvLoader.h"
+#include "MarketCache.h"
+#include "Profiler.h"
+#include "Memory.h"
+#include "CompressedColumn.h"
+
+namespace
+{
+    const char* DATA_FILE = "TradingApp/data/all_stocks_5yr.csv";
+
+    // the main loop sleeps until input or a wake event, and otherwise redraws at these rates
+    constexpr Uint32 ACTIVE_FRAME_MS = 16; // cap while input keeps coming
+    constexpr Uint32 BUSY_FRAME_MS = 50;   // loads, backtests, fetches and the live bus move without input
+    constexpr Uint32 IDLE_FRAME_MS = 1000;
+    // imgui needs a few frames after an event to settle hover states, window moves and resizes
+    constexpr int SETTLE_FRAMES = 3;
+
+    Uint32 wakeEventType = (Uint32)-1;
+
+    // safe from any thread, makes the main loop draw a frame soon
+    void WakeMainLoop()
+    {
+        if (wakeEventType == (Uint32)-1)
+            return;
+        SDL_Event event{};
+        event.type = wakeEventType;
+        SDL_PushEvent(&event);
+    }
+}
  
 template <typename T>
 int BinarySearch(const T* arr, int l, int r, T x) {
@@ -61,13 +97,12 @@ void checkSDLError(int line = -1)
 #endif
 }
 
-void App::Run()
+void App::RunOrderBookDemo()
 {
-    
     OrderBook orderBook;
 
     const OrderID orderID = 1;
-    orderBook.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, orderID, Side::Buy, 20, 100));
+    orderBook.AddOrder(orderBook.CreateOrder(OrderType::GoodTillCancel, orderID, Side::Buy, 20, 100));
 
     std::cout << orderBook.Size() << std::endl;
     orderBook.CancelOrder(orderID);
@@ -78,8 +113,8 @@ void App::Run()
     {
         int randomBuy  = int(float(rand()) / RAND_MAX * 200);
         int randomSell = int(float(rand()) / RAND_MAX * 200);
-        orderBook.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, i, Side::Buy, Price(1900 + (i / 17) * 17), randomBuy));
-        orderBook.AddOrder(std::make_shared<Order>(OrderType::GoodTillCancel, i + 2000, Side::Sell, Price(2000 - (i / 17) * 17), randomSell));
+        orderBook.AddOrder(orderBook.CreateOrder(OrderType::GoodTillCancel, i, Side::Buy, Price(1900 + (i / 17) * 17), randomBuy));
+        orderBook.AddOrder(orderBook.CreateOrder(OrderType::GoodTillCancel, i + 2000, Side::Sell, Price(2000 - (i / 17) * 17), randomSell));
     }
 
     {
@@ -116,26 +151,51 @@ void App::Run()
             printf("Price %4d [%4d]\n", bid.price, bid.quantity);
         }
     }
+}
 
-    return;
+void App::ParseArgs(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--engine") == 0)
+            mode = AppMode::Engine;
+        else if (std::strcmp(argv[i], "--viewer") == 0)
+            mode = AppMode::Viewer;
+        else if (std::strcmp(argv[i], "--follow") == 0)
+            follow = true;
+        else if (std::strcmp(argv[i], "--pages") == 0 && i + 1 < argc)
+        {
+            if (Memory::ParsePagePolicy(argv[++i], placement.pages) == false)
+                printf("Unknown page policy %s\n", argv[i]);
+        }
+        else if (std::strcmp(argv[i], "--numa") == 0)
+            placement.localNode = true;
+        else if (std::strcmp(argv[i], "--prefault") == 0)
+            placement.prefault = true;
+        else
+            printf("Unknown argument %s\n", argv[i]);
+    }
 
-    curl_global_init(CURL_GLOBAL_ALL);
-    CURL* curl = curl_easy_init();
-    curl_easy_setopt(curl, CURLOPT_URL, "http://example.com");
-    CURLcode res = curl_easy_perform(curl);
+    for (size_t t = 0; t < (size_t)MemoryTag::Count; ++t)
+        Memory::SetPlacement((MemoryTag)t, placement);
+}
 
-    if (res != CURLE_OK) {
-        fprintf(stderr, "curl_easy_perform() failed: %s\n", curl_easy_strerror(res));
-    }
-    else
+void App::Run()
+{
+    if (mode == AppMode::Engine)
     {
-
+        RunEngine();
+        return;
     }
-    
-    curl_easy_cleanup(curl);
-    curl_global_cleanup();
 
+    if (mode == AppMode::Default)
+    {
+        RunOrderBookDemo();
+        return;
+    }
 
+    PROFILE_THREAD("Main");
+    busSubscriber = std::make_unique<MarketDataSubscriber>(BUS_DEFAULT_NAME);
 
     SDL_Window *mainwindow; /* Our window handle */
     SDL_GLContext maincontext; /* Our opengl context handle */
@@ -175,8 +235,9 @@ void App::Run()
         std::cout << "error loading opengl functions\n";
     }
 
-    /* This makes our buffer swap syncronized with the monitor's vertical refresh */
+    /* No vsync, frames are paced by the wait at the top of the main loop instead */
     SDL_GL_SetSwapInterval(0);
+    wakeEventType = SDL_RegisterEvents(1);
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
@@ -208,29 +269,65 @@ void App::Run()
     ImGui_ImplSDL2_InitForOpenGL(mainwindow, maincontext);
     ImGui_ImplOpenGL3_Init(glsl_version);
 
-    bool show_demo_window = true;
+    bool show_demo_window = false; // the demos animate, which keeps the loop at the active rate
     bool done = false;
 
     glm::vec4 clear_color{ 0.2f };
-    ParseFile("TradingApp/data/all_stocks_5yr.csv");
-
+    // first frame does not wait for the data, symbols appear as the loader finishes them
+    loadThread = std::jthread([this] {
+        PROFILE_THREAD("Loader");
+        ParseFile(DATA_FILE);
+        WakeMainLoop();
+    });
+    fetcher.SetOnResult(WakeMainLoop);
+
+    // Poll and handle events (inputs, window resize, etc.)
+    // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
+    // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application, or clear/overwrite your copy of the mouse data.
+    // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application, or clear/overwrite your copy of the keyboard data.
+    // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
+    int settleFrames = SETTLE_FRAMES;
+    auto handleEvent = [&](SDL_Event& event) {
+        ImGui_ImplSDL2_ProcessEvent(&event);
+        if (event.type == SDL_QUIT)
+            done = true;
+        if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE && event.window.windowID == SDL_GetWindowID(mainwindow))
+            done = true;
+        settleFrames = SETTLE_FRAMES;
+    };
+
+    Uint32 lastFrame = 0;
     while (!done)
     {
-
-        // Poll and handle events (inputs, window resize, etc.)
-        // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
-        // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application, or clear/overwrite your copy of the mouse data.
-        // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application, or clear/overwrite your copy of the keyboard data.
-        // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
         SDL_Event event;
-        while (SDL_PollEvent(&event))
+        if (show_demo_window || io.WantTextInput)
+            settleFrames = std::max(settleFrames, 1);
+
+        // nothing changed since the last frames settled, sleep until something does
+        if (settleFrames == 0)
         {
-            ImGui_ImplSDL2_ProcessEvent(&event);
-            if (event.type == SDL_QUIT)
-                done = true;
-            if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE && event.window.windowID == SDL_GetWindowID(mainwindow))
-                done = true;
+            const bool busy = loadProgress.Done() == false || backtestRunning || fetcher.Pending() != 0 || busSubscriber->IsOpen();
+            if (SDL_WaitEventTimeout(&event, busy ? BUSY_FRAME_MS : IDLE_FRAME_MS))
+                handleEvent(event);
+        }
+
+        // frames follow each other no faster than the cap, input arriving meanwhile is handled right away
+        for (;;)
+        {
+            const Uint32 elapsed = SDL_GetTicks() - lastFrame;
+            if (elapsed >= ACTIVE_FRAME_MS)
+            {
+                while (SDL_PollEvent(&event))
+                    handleEvent(event);
+                break;
+            }
+            if (SDL_WaitEventTimeout(&event, (int)(ACTIVE_FRAME_MS - elapsed)))
+                handleEvent(event);
         }
+        lastFrame = SDL_GetTicks();
+        settleFrames = std::max(settleFrames - 1, 0);
+
+        PROFILE_SCOPE("Frame");
 
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -239,6 +336,9 @@ void App::Run()
 
         ImGui::DockSpaceOverViewport();
 
+        ApplyFollowedRows();
+        ApplyFetchedData();
+
         // 1. Show the big demo window (Most of the sample code is in ImGui::ShowDemoWindow()! You can browse its code to learn more about Dear ImGui!).
         if (show_demo_window)
         {
@@ -247,6 +347,13 @@ void App::Run()
         }
 
         ShowTraderWindow();
+        ShowMarketDataWindow();
+        ShowCorrelationWindow();
+        ShowScreenerWindow();
+        ShowBacktestWindow();
+        ShowFetchWindow();
+        ShowProfilerWindow();
+        ShowMemoryWindow();
 
 
         // 2. Show a simple window that we create ourselves. We use a Begin/End pair to create a named window.
@@ -273,11 +380,14 @@ void App::Run()
 
 
         // Rendering
-        ImGui::Render();
-        glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
-        glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            PROFILE_SCOPE("Render");
+            ImGui::Render();
+            glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
+            glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         // Update and Render additional Platform Windows
         // (Platform functions may change the current OpenGL context, so we save/restore it to make it easier to paste this code elsewhere.
@@ -291,6 +401,7 @@ void App::Run()
             SDL_GL_MakeCurrent(backup_current_window, backup_current_context);
         }
 
+        PROFILE_SCOPE("Swap");
         SDL_GL_SwapWindow(mainwindow);
     }
 
@@ -313,43 +424,116 @@ void App::Run()
 #include <filesystem>
 #include <chrono>
 
+namespace
+{
+    std::atomic<bool> engineRunning{ false };
+
+    void StopEngine(int)
+    {
+        engineRunning = false;
+    }
+}
+
+void App::RunEngine()
+{
+    MarketDataPublisher publisher(BUS_DEFAULT_NAME);
+    if (publisher.IsOpen() == false)
+        return;
+
+    OrderBook orderBook;
+    // the order index for a busy session, faulted in now rather than while publishing
+    if (placement.prefault)
+        orderBook.Reserve(1 << 16);
+
+    engineRunning = true;
+    std::signal(SIGINT, StopEngine);
+    printf("Engine publishing on %s, ctrl+c to stop\n", BUS_DEFAULT_NAME);
+
+    std::mt19937 rng(01337);
+    std::normal_distribution<double> walk(0.0, 0.5);
+    std::uniform_int_distribution<int> offset(-20, 20);
+    std::uniform_int_distribution<Quantity> size(1, 200);
+    std::bernoulli_distribution isBuy(0.5);
+    std::bernoulli_distribution isCancel(0.2);
+    std::bernoulli_distribution isIceberg(0.05);
+
+    std::vector<OrderID> liveOrders;
+    OrderID nextID = 1;
+    double mid = 2000.0;
+    auto lastDepth = std::chrono::steady_clock::now();
+
+    while (engineRunning)
+    {
+        mid = std::max(100.0, mid + walk(rng));
+
+        if (isCancel(rng) && liveOrders.empty() == false)
+        {
+            size_t pick = std::uniform_int_distribution<size_t>(0, liveOrders.size() - 1)(rng);
+            orderBook.CancelOrder(liveOrders[pick]);
+            liveOrders[pick] = liveOrders.back();
+            liveOrders.pop_back();
+        }
+        else
+        {
+            Side side = isBuy(rng) ? Side::Buy : Side::Sell;
+            Price price = Price(mid) + offset(rng);
+            // some large orders only show a slice of themselves in the depth
+            OrderRef order = isIceberg(rng)
+                ? orderBook.CreateIceberg(nextID, side, price, size(rng) * 10, size(rng))
+                : orderBook.CreateOrder(OrderType::GoodTillCancel, nextID, side, price, size(rng));
+            liveOrders.push_back(nextID++);
+            publisher.PublishTrades(orderBook.AddOrder(order), side);
+        }
+
+        // depth snapshots at a fixed cadence, trades go out as they happen
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastDepth >= std::chrono::milliseconds(10))
+        {
+            publisher.PublishDepth(orderBook.GetOrderInfos());
+            lastDepth = now;
+        }
+
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    printf("Engine stopped at sequence %llu\n", (unsigned long long)publisher.Sequence());
+}
+
+
 void App::ParseFile(const char* fileName)
 {
+    PROFILE_SCOPE("App::ParseFile");
     auto begin = std::chrono::high_resolution_clock::now();
 
-    std::fstream fs(fileName);
-    
-    if (!fs)
+    std::string cacheName = std::string(fileName) + ".cache";
+    if (LoadMarketCache(cacheName.c_str(), fileName, marketCache, market))
     {
-        std::printf("Cannot open file %s\n", fileName);
-        auto cp = std::filesystem::current_path();
-        std::printf("Current path is %s\n", (char*)cp.u8string().c_str());
-       
+        std::printf("Loaded cache %s\n", cacheName.c_str());
+        loadProgress.Reset(market.Count(), true);
+        // the cache holds the rows up to the last newline when it was written, a follower takes the rest
+        loadProgress.SetSourceBytes(follow ? WholeLineBytes(fileName) : std::filesystem::file_size(fileName));
+        loadProgress.Publish();
     }
-
-    //parse and discard header{
+    else if (LoadCsv(fileName, market, 0, &loadProgress, follow))
     {
-        std::string d;
-        std::getline(fs, d,'\n');
+        if (WriteMarketCache(cacheName.c_str(), fileName, market) == false)
+            std::printf("Cannot write cache %s\n", cacheName.c_str());
     }
-    while (fs)
+    else
     {
-        DataFrame df{};
-        std::string name;
-        if (ParseLine(fs, df, name))
-        {
-            dataMap[name].PushData(df);
-        }
-    }    
+        std::printf("Cannot open file %s\n", fileName);
+        auto cp = std::filesystem::current_path();
+        std::printf("Current path is %s\n", (char*)cp.u8string().c_str());
+        loadProgress.Reset(0, true);
+        loadProgress.Publish();
+    }
 
     size_t max = 0;
     size_t min = LONG_MAX;
     size_t sumEntries = 0;
-    for (auto& it : dataMap)
+    for (const DataStore& ds : market.Stores())
     {
-        it.second.name = it.first;
-        names.push_back(it.second.name.c_str());
-        size_t sz = it.second.size();
+        size_t sz = ds.size();
         sumEntries += sz;
 
         max = std::max(max, sz);
@@ -363,46 +547,102 @@ void App::ParseFile(const char* fileName)
     std::printf("Parsing Took %f\n", (float)ms / 1000.0f);
     
     std::printf("[Total entries %zd]\n", sumEntries);
-    std::printf("Num Categories %zd\n", dataMap.size());
+    std::printf("Num Categories %zd\n", market.Count());
     std::printf("Max entries %zd\n", max);
     std::printf("Min entries %zd\n", min);
+
+    // last, the cache writer and the stats above still read every column
+    loadProgress.Finish();
+}
+
+void App::ApplyFollowedRows()
+{
+    PROFILE_SCOPE("App::ApplyFollowedRows");
+    if (follow == false || loadProgress.Done() == false || backtestRunning)
+        return;
+
+    // following starts where the load stopped, rows are appended on this thread only
+    static bool started = false;
+    if (started == false)
+    {
+        if (follower.Start(DATA_FILE, loadProgress.SourceBytes(), WakeMainLoop))
+            std::printf("Following %s from byte %llu\n", DATA_FILE, (unsigned long long)loadProgress.SourceBytes());
+        started = true;
+    }
+
+    static std::vector<FollowedRow> rows;
+    rows.clear();
+    if (follower.Drain(rows) == 0)
+        return;
+
+    // dates must stay sorted for the resampler, the date index and block extents,
+    // so a row repeating the newest date replaces it and older rows are dropped
+    for (const FollowedRow& row : rows)
+    {
+        DataStore& ds = market.Get(market.Intern(row.name));
+        if (ds.IsCompressed())
+            ds.Decompress();
+        if (ds.size() == 0 || row.frame.date > ds.date.back())
+            ds.PushData(row.frame);
+        else if (row.frame.date == ds.date.back())
+            ds.UpdateLast(row.frame);
+    }
+    ++marketVersion;
 }
 
-bool App::ParseLine(std::fstream& file, DataFrame& outFrame, std::string& outName)
+void App::ApplyFetchedData()
 {
-    const char delimiter = ',';
-	std::string date;
-    std::string	open;
-    std::string	high;
-    std::string low;
-    std::string close;
-    std::string	volume;
-    std::string	name;
-    if (std::getline(file, date,delimiter )
-        && std::getline(file, open, delimiter)
-        && std::getline(file, high, delimiter)
-        && std::getline(file, low, delimiter)
-        && std::getline(file, close, delimiter)
-        && std::getline(file, volume, delimiter)
-        && std::getline(file, name, '\n')
-        )
-    {
-		outFrame.date = !date.empty() ? (double)(std::stoull(date)/1000) : 0;
-		outFrame.open = !open.empty() ? std::stod(open) : 0;
-		outFrame.high = !high.empty() ? std::stod(high) : 0;
-		outFrame.low = !low.empty() ? std::stod(low) : 0;
-		outFrame.close = !close.empty() ? std::stod(close) : 0;
-		outFrame.volume = !volume.empty() ? std::stod(volume) : 0;
-
-        outName = std::move(name);
-        return true;
-    }
-
-    return false;
+    PROFILE_SCOPE("App::ApplyFetchedData");
+    if (loadProgress.Done() == false || backtestRunning)
+        return;
+
+    static std::vector<FetchResult> results;
+    results.clear();
+    if (fetcher.Drain(results) == 0)
+        return;
+
+    bool appended = false;
+    for (FetchResult& result : results)
+    {
+        fetchStatus.bytes += result.bytes;
+        if (result.ok == false)
+        {
+            ++fetchStatus.failed;
+            std::printf("Fetching %s failed: %s\n", result.url.c_str(), result.error.c_str());
+            continue;
+        }
+        ++fetchStatus.succeeded;
+
+        // a refresh repeats known history, only the newest bar and anything after it is taken
+        for (const DataStore& fetched : result.stores)
+        {
+            DataStore& ds = market.Get(market.Intern(fetched.name));
+            // the dates to compare against are in the columns, a compressed symbol has none until decompressed
+            if (ds.IsCompressed())
+                ds.Decompress();
+            for (size_t i = 0; i < fetched.size(); ++i)
+            {
+                DataFrame df{ fetched.date[i], fetched.open[i], fetched.close[i], fetched.high[i], fetched.low[i], fetched.volume[i] };
+                if (ds.size() == 0 || df.date > ds.date.back())
+                    ds.PushData(df);
+                else if (df.date == ds.date.back())
+                    ds.UpdateLast(df);
+                else
+                    continue;
+                appended = true;
+            }
+        }
+    }
+
+    if (fetcher.Pending() == 0)
+        fetchStatus.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - fetchStatus.start).count();
+    if (appended)
+        ++marketVersion;
 }
 
 void App::ShowTraderWindow()
 {
+    PROFILE_SCOPE("App::ShowTraderWindow");
     if (ImGui::Begin("Trade Window"))
     {
         double dates[]  = {1546300800,1546387200,1546473600,1546560000,1546819200,1546905600,1546992000,1547078400,1547164800,1547424000,1547510400,1547596800,1547683200,1547769600,1547942400,1548028800,1548115200,1548201600,1548288000,1548374400,1548633600,1548720000,1548806400,1548892800,1548979200,1549238400,1549324800,1549411200,1549497600,1549584000,1549843200,1549929600,1550016000,1550102400,1550188800,1550361600,1550448000,1550534400,1550620800,1550707200,1550793600,1551052800,1551139200,1551225600,1551312000,1551398400,1551657600,1551744000,1551830400,1551916800,1552003200,1552262400,1552348800,1552435200,1552521600,1552608000,1552867200,1552953600,1553040000,1553126400,1553212800,1553472000,1553558400,1553644800,1553731200,1553817600,1554076800,1554163200,1554249600,1554336000,1554422400,1554681600,1554768000,1554854400,1554940800,1555027200,1555286400,1555372800,1555459200,1555545600,1555632000,1555891200,1555977600,1556064000,1556150400,1556236800,1556496000,1556582400,1556668800,1556755200,1556841600,1557100800,1557187200,1557273600,1557360000,1557446400,1557705600,1557792000,1557878400,1557964800,1558051200,1558310400,1558396800,1558483200,1558569600,1558656000,1558828800,1558915200,1559001600,1559088000,1559174400,1559260800,1559520000,1559606400,1559692800,1559779200,1559865600,1560124800,1560211200,1560297600,1560384000,1560470400,1560729600,1560816000,1560902400,1560988800,1561075200,1561334400,1561420800,1561507200,1561593600,1561680000,1561939200,1562025600,1562112000,1562198400,1562284800,1562544000,1562630400,1562716800,1562803200,1562889600,1563148800,1563235200,1563321600,1563408000,1563494400,1563753600,1563840000,1563926400,1564012800,1564099200,1564358400,1564444800,1564531200,1564617600,1564704000,1564963200,1565049600,1565136000,1565222400,1565308800,1565568000,1565654400,1565740800,1565827200,1565913600,1566172800,1566259200,1566345600,1566432000,1566518400,1566777600,1566864000,1566950400,1567036800,1567123200,1567296000,1567382400,1567468800,1567555200,1567641600,1567728000,1567987200,1568073600,1568160000,1568246400,1568332800,1568592000,1568678400,1568764800,1568851200,1568937600,1569196800,1569283200,1569369600,1569456000,1569542400,1569801600,1569888000,1569974400,1570060800,1570147200,1570406400,1570492800,1570579200,1570665600,1570752000,1571011200,1571097600,1571184000,1571270400,1571356800,1571616000,1571702400,1571788800,1571875200,1571961600};
@@ -412,14 +652,154 @@ void App::ShowTraderWindow()
         double closes[] = {1283.35,1315.3,1326.1,1317.4,1321.5,1317.4,1323.5,1319.2,1321.3,1323.3,1319.7,1325.1,1323.6,1313.8,1282.05,1279.05,1314.2,1315.2,1310.8,1329.1,1334.5,1340.2,1340.5,1350,1347.1,1344.3,1344.6,1339.7,1339.4,1343.7,1337,1338.9,1340.1,1338.7,1346.8,1324.25,1329.55,1369.6,1372.5,1352.4,1357.6,1354.2,1353.4,1346,1341,1323.8,1311.9,1309.1,1312.2,1310.7,1324.3,1315.7,1322.4,1333.8,1319.4,1327.1,1325.8,1330.9,1325.8,1331.6,1336.5,1346.7,1339.2,1334.7,1313.3,1316.5,1312.4,1313.4,1313.3,1312.2,1313.7,1319.9,1326.3,1331.9,1311.3,1313.4,1309.4,1295.2,1294.7,1294.1,1277.9,1295.8,1291.2,1297.4,1297.7,1306.8,1299.4,1303.6,1302.2,1289.9,1299.2,1301.8,1303.6,1299.5,1303.2,1305.3,1319.5,1313.6,1315.1,1303.5,1293,1294.6,1290.4,1291.4,1302.7,1301,1284.15,1284.95,1294.3,1297.9,1304.1,1322.6,1339.3,1340.1,1344.9,1354,1357.4,1340.7,1342.7,1348.2,1355.1,1355.9,1354.2,1362.1,1360.1,1408.3,1411.2,1429.5,1430.1,1426.8,1423.4,1425.1,1400.8,1419.8,1432.9,1423.55,1412.1,1412.2,1412.8,1424.9,1419.3,1424.8,1426.1,1423.6,1435.9,1440.8,1439.4,1439.7,1434.5,1436.5,1427.5,1432.2,1433.3,1441.8,1437.8,1432.4,1457.5,1476.5,1484.2,1519.6,1509.5,1508.5,1517.2,1514.1,1527.8,1531.2,1523.6,1511.6,1515.7,1515.7,1508.5,1537.6,1537.2,1551.8,1549.1,1536.9,1529.4,1538.05,1535.15,1555.9,1560.4,1525.5,1515.5,1511.1,1499.2,1503.2,1507.4,1499.5,1511.5,1513.4,1515.8,1506.2,1515.1,1531.5,1540.2,1512.3,1515.2,1506.4,1472.9,1489,1507.9,1513.8,1512.9,1504.4,1503.9,1512.8,1500.9,1488.7,1497.6,1483.5,1494,1498.3,1494.1,1488.1,1487.5,1495.7,1504.7,1505.3};
         static bool tooltip = true;
 
+        if (loadProgress.Indexed() == false)
+        {
+            ImGui::Text("Indexing market data...");
+            ImGui::End();
+            return;
+        }
+
+        if (loadProgress.Done() == false)
+        {
+            char overlay[64];
+            if (loadProgress.Loaded() == loadProgress.Total())
+                std::snprintf(overlay, sizeof(overlay), "Writing cache");
+            else
+                std::snprintf(overlay, sizeof(overlay), "%zd / %zd symbols", loadProgress.Loaded(), loadProgress.Total());
+            ImGui::ProgressBar((float)loadProgress.Loaded() / (float)std::max<size_t>(loadProgress.Total(), 1), ImVec2(-FLT_MIN, 0), overlay);
+        }
+
+        if (follower.Running())
+            ImGui::Text("Following %s", DATA_FILE);
+
         static int selector = 0;
-        if (ImGui::ListBox("Markets", &selector, names.data(), (int)names.size()))
+        if (ImGui::ListBox("Markets", &selector, market.Names(), (int)market.Count()))
         {
            // light.info.w = light_type_selector + 1;
         }
 
-        DataStore& ds = dataMap[names[selector]];
-        
+        if (market.Empty())
+        {
+            ImGui::End();
+            return;
+        }
+
+        if (loadProgress.Ready((SymbolID)selector) == false)
+        {
+            // pull the selected symbol to the front of the load queue
+            loadProgress.Prioritize((SymbolID)selector);
+            ImGui::Text("Loading %s...", market.Names()[selector]);
+            ImGui::End();
+            return;
+        }
+
+        // compressed symbols are left out of indicators, correlation, screens and backtests until decompressed,
+        // each of those reports how many it left out
+        static size_t packedBytes = 0, rawBytes = 0;
+        ImGui::BeginDisabled(loadProgress.Done() == false || backtestRunning);
+        if (ImGui::Button("Compress history"))
+        {
+            market.Compress();
+            market.CompressedSize(packedBytes, rawBytes);
+            ++marketVersion;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Decompress history"))
+        {
+            market.Decompress();
+            market.CompressedSize(packedBytes, rawBytes);
+            ++marketVersion;
+        }
+        ImGui::EndDisabled();
+        if (packedBytes != 0)
+        {
+            ImGui::SameLine(); ImGui::Text("%.1f MB packed from %.1f MB", packedBytes / (1024.0 * 1024.0), rawBytes / (1024.0 * 1024.0));
+        }
+
+        DataStore& ds = market.Get((SymbolID)selector);
+        if (ds.IsCompressed())
+        {
+            PlotCompressedHistory(ds, tooltip);
+            ImGui::End();
+            return;
+        }
+        if (ds.HasExtents() == false)
+            ds.BuildExtents();
+
+        // coarser bars come from the prebuilt resampled levels, auto picks by zoom
+        static int barMode = 0;
+        static int barCount = 10;
+        static double daysPerPixel = 0.0;
+        const char* barModes[] = { "Auto", "Daily", "Weekly", "Monthly", "N Days" };
+        ImGui::Combo("Bars", &barMode, barModes, IM_ARRAYSIZE(barModes));
+        if (barMode == 4)
+        {
+            ImGui::SameLine(); ImGui::SliderInt("##BarCount", &barCount, 2, 60);
+        }
+
+        int shownMode = barMode;
+        if (barMode == 0)
+            shownMode = daysPerPixel > 15.0 ? 3 : daysPerPixel > 3.0 ? 2 : 1;
+
+        const DataStore* bars = &ds;
+        if (shownMode == 2)
+            bars = &market.Resampled((SymbolID)selector, ResampleSpec{ BarInterval::Weekly });
+        else if (shownMode == 3)
+            bars = &market.Resampled((SymbolID)selector, ResampleSpec{ BarInterval::Monthly });
+        else if (shownMode == 4)
+            bars = &market.Resampled((SymbolID)selector, ResampleSpec{ BarInterval::Bars, (uint32_t)barCount });
+
+        // indicators run on the daily rows and overlay whatever bar size is shown
+        static bool showSma = false, showEma = false, showBollinger = false, showVwap = false, showChannel = false;
+        static bool showRsi = false, showAtr = false;
+        static int period = 20;
+        static double updateAllMs = -1.0;
+        static size_t updateAllCompressed = 0;
+        ImGui::Checkbox("SMA", &showSma); ImGui::SameLine();
+        ImGui::Checkbox("EMA", &showEma); ImGui::SameLine();
+        ImGui::Checkbox("Bollinger", &showBollinger); ImGui::SameLine();
+        ImGui::Checkbox("VWAP", &showVwap); ImGui::SameLine();
+        ImGui::Checkbox("High/Low", &showChannel); ImGui::SameLine();
+        ImGui::Checkbox("RSI", &showRsi); ImGui::SameLine();
+        ImGui::Checkbox("ATR", &showAtr);
+        ImGui::SliderInt("Period", &period, 2, 200);
+        ImGui::BeginDisabled(loadProgress.Done() == false);
+        const bool computeAll = ImGui::Button("Compute for all symbols");
+        ImGui::EndDisabled();
+        if (computeAll)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (IndicatorType type : { IndicatorType::SMA, IndicatorType::EMA, IndicatorType::Bollinger, IndicatorType::VWAP, IndicatorType::RSI, IndicatorType::ATR })
+                updateAllCompressed = indicators.UpdateAll(market, IndicatorSpec{ type, (uint32_t)period });
+            updateAllMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+        if (updateAllMs >= 0.0)
+        {
+            ImGui::SameLine(); ImGui::Text("%.2f ms for %zd symbols%s", updateAllMs, market.Count() - updateAllCompressed, Indicators::HasAvx2() ? " (AVX2)" : "");
+            if (updateAllCompressed != 0)
+            {
+                ImGui::SameLine(); ImGui::TextDisabled("%zd compressed symbols left out", updateAllCompressed);
+            }
+        }
+
+        const SymbolID symbol = (SymbolID)selector;
+        auto indicator = [&](IndicatorType type) -> const IndicatorSeries& {
+            return indicators.Get(symbol, ds, IndicatorSpec{ type, (uint32_t)period });
+        };
+
+        // only the rows inside the visible date range are handed to implot
+        static double visibleMin = 0.0, visibleMax = 0.0;
+        auto plotVisible = [&](const char* label, const std::vector<double>& values) {
+            const double* first = std::lower_bound(ds.date.begin(), ds.date.end(), visibleMin);
+            const double* last = std::upper_bound(first, ds.date.end(), visibleMax);
+            if (first != ds.date.begin())
+                --first;
+            if (last != ds.date.end())
+                ++last;
+            const size_t offset = first - ds.date.begin();
+            ImPlot::PlotLine(label, first, values.data() + offset, (int)(last - first), ImPlotLineFlags_SkipNaN);
+        };
+
         if (ImPlot::BeginPlot("My Stock Chart",ImVec2(-1,0))) {
             ImPlot::SetupAxes("Date", "Price", 0, ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_RangeFit);
             ImPlot::SetupAxesLimits(ds.date.front(), ds.date.back(), ds.minimum, ds.maximum);
@@ -435,16 +815,1046 @@ void App::ShowTraderWindow()
             ImGui::SameLine(); ImGui::ColorEdit4("##Bull", &bullCol.x, ImGuiColorEditFlags_NoInputs);
             ImGui::SameLine(); ImGui::ColorEdit4("##Bear", &bearCol.x, ImGuiColorEditFlags_NoInputs);
 
-            App::PlotCandlestick(ds.name.c_str(), ds.date.data(), ds.open.data(), ds.close.data(), ds.low.data(), ds.high.data(), (int)ds.size(), tooltip, 0.25f, bullCol, bearCol);
+            App::PlotCandlestick(ds.name.c_str(), *bars, tooltip, 0.25f, bullCol, bearCol);
+
+            ImPlotRect limits = ImPlot::GetPlotLimits();
+            visibleMin = limits.X.Min;
+            visibleMax = limits.X.Max;
+
+            if (showSma)
+                plotVisible("SMA", indicator(IndicatorType::SMA).values);
+            if (showEma)
+                plotVisible("EMA", indicator(IndicatorType::EMA).values);
+            if (showVwap)
+                plotVisible("VWAP", indicator(IndicatorType::VWAP).values);
+            if (showBollinger)
+            {
+                const IndicatorSeries& bands = indicator(IndicatorType::Bollinger);
+                plotVisible("Bollinger", bands.values);
+                plotVisible("Bollinger Upper", bands.upper);
+                plotVisible("Bollinger Lower", bands.lower);
+            }
+            if (showChannel)
+            {
+                plotVisible("Rolling High", indicator(IndicatorType::RollingMax).values);
+                plotVisible("Rolling Low", indicator(IndicatorType::RollingMin).values);
+            }
+
+            const double visibleDays = ImPlot::GetPlotLimits().X.Size() / oneDay;
+            daysPerPixel = visibleDays / std::max(1.0f, ImPlot::GetPlotSize().x);
+            ImPlot::EndPlot();
+        }
+
+        // oscillators get their own plot that follows the price chart's dates
+        if ((showRsi || showAtr) && ImPlot::BeginPlot("Oscillators", ImVec2(-1, 150)))
+        {
+            ImPlot::SetupAxes(nullptr, nullptr, 0, ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_RangeFit);
+            ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Time);
+            ImPlot::SetupAxisLimits(ImAxis_X1, visibleMin, visibleMax, ImPlotCond_Always);
+
+            if (showRsi)
+                plotVisible("RSI", indicator(IndicatorType::RSI).values);
+            if (showAtr)
+                plotVisible("ATR", indicator(IndicatorType::ATR).values);
+            ImPlot::EndPlot();
+        }
+
+    }
+    ImGui::End();
+}
+
+
+void App::ShowCorrelationWindow()
+{
+    PROFILE_SCOPE("App::ShowCorrelationWindow");
+    if (ImGui::Begin("Correlation"))
+    {
+        if (loadProgress.Done() == false)
+        {
+            ImGui::Text("Waiting for every symbol to load");
+            ImGui::End();
+            return;
+        }
+
+        if (market.Empty())
+        {
+            ImGui::End();
+            return;
+        }
+
+        static bool dirty = true;
+        bool rebuild = correlation.Symbols() != market.Count();
+        if (correlationVersion != marketVersion)
+        {
+            // appended rows shift the joined date axis, so they need a full rebuild
+            ImGui::Text("New rows since the matrix was built");
+            ImGui::SameLine();
+            rebuild |= ImGui::Button("Rebuild");
+        }
+        if (rebuild)
+        {
+            correlation.Build(market);
+            correlationVersion = marketVersion;
+            dirty = true;
+        }
+
+        const int days = (int)correlation.Days();
+        if (days < 2)
+        {
+            ImGui::Text("Not enough history");
+            ImGui::End();
+            return;
+        }
+
+        static int windowDays = 250;
+        static int windowEnd = INT_MAX;
+        static bool showCovariance = false;
+        static double updateMs = 0.0;
+
+        windowEnd = std::clamp(windowEnd, 2, days);
+        windowDays = std::clamp(windowDays, 2, windowEnd);
+        dirty |= ImGui::SliderInt("Window Days", &windowDays, 2, windowEnd);
+        dirty |= ImGui::SliderInt("Window End", &windowEnd, 2, days);
+        ImGui::Checkbox("Covariance", &showCovariance);
+
+        if (dirty)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            correlation.SetWindow(windowEnd - windowDays, windowEnd);
+            updateMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            dirty = false;
+        }
+
+        auto dateText = [](double date, char* buffer, size_t size) {
+            time_t seconds = (time_t)date;
+            std::strftime(buffer, size, "%Y-%m-%d", std::gmtime(&seconds));
+        };
+        char from[16], to[16];
+        dateText(correlation.Dates()[correlation.WindowFirst()], from, sizeof(from));
+        dateText(correlation.Dates()[correlation.WindowLast() - 1], to, sizeof(to));
+        ImGui::Text("%s to %s, %zd symbols, updated in %.2f ms", from, to, correlation.Symbols(), updateMs);
+        if (correlation.CompressedSymbols() != 0)
+        {
+            ImGui::SameLine(); ImGui::TextDisabled("%zd compressed symbols left out", correlation.CompressedSymbols());
+        }
+
+        const int n = (int)correlation.Symbols();
+        const std::vector<double>& values = showCovariance ? correlation.Covariance() : correlation.Correlation();
+        double scaleMin = -1.0, scaleMax = 1.0;
+        if (showCovariance)
+        {
+            auto [low, high] = std::minmax_element(values.begin(), values.end());
+            scaleMax = std::max(std::abs(*low), std::abs(*high));
+            scaleMin = -scaleMax;
+        }
+
+        ImPlot::PushColormap(ImPlotColormap_RdBu);
+        const float side = std::min(ImGui::GetContentRegionAvail().x - 80.0f, ImGui::GetContentRegionAvail().y);
+        if (ImPlot::BeginPlot("##Heatmap", ImVec2(side, side), ImPlotFlags_NoLegend | ImPlotFlags_NoMouseText))
+        {
+            ImPlot::SetupAxes(nullptr, nullptr, ImPlotAxisFlags_NoDecorations, ImPlotAxisFlags_NoDecorations);
+            ImPlot::PlotHeatmap("##Values", values.data(), n, n, scaleMin, scaleMax, nullptr, ImPlotPoint(0, 0), ImPlotPoint(n, n));
+
+            if (ImPlot::IsPlotHovered())
+            {
+                ImPlotPoint mouse = ImPlot::GetPlotMousePos();
+                const int col = (int)mouse.x;
+                const int row = n - 1 - (int)mouse.y;
+                if (col >= 0 && col < n && row >= 0 && row < n)
+                {
+                    ImGui::SetTooltip("%s / %s: %.4g", market.Names()[row], market.Names()[col], values[(size_t)row * n + col]);
+                }
+            }
+            ImPlot::EndPlot();
+        }
+        ImGui::SameLine();
+        ImPlot::ColormapScale("##Scale", scaleMin, scaleMax, ImVec2(60, side));
+        ImPlot::PopColormap();
+    }
+    ImGui::End();
+}
+
+void App::ShowScreenerWindow()
+{
+    PROFILE_SCOPE("App::ShowScreenerWindow");
+    if (ImGui::Begin("Screener"))
+    {
+        if (loadProgress.Done() == false)
+        {
+            ImGui::Text("Waiting for every symbol to load");
+            ImGui::End();
+            return;
+        }
+
+        if (market.Empty())
+        {
+            ImGui::End();
+            return;
+        }
+
+        static bool dirty = true;
+        // a fraction of a load, so the index simply follows every change to the market
+        if (dateIndex.Symbols() != market.Count() || dateIndexVersion != marketVersion)
+        {
+            dateIndex.Build(market);
+            dateIndexVersion = marketVersion;
+            dirty = true;
+        }
+
+        const int days = (int)dateIndex.Days();
+        if (days == 0)
+        {
+            ImGui::Text("No history");
+            ImGui::End();
+            return;
+        }
+
+        static int day = INT_MAX;
+        static int rangeDays = 1;
+        static ScreenQuery query;
+        static std::vector<ScreenHit> hits;
+        static double runMs = 0.0;
+
+        auto dateText = [](double date, char* buffer, size_t size) {
+            time_t seconds = (time_t)date;
+            std::strftime(buffer, size, "%Y-%m-%d", std::gmtime(&seconds));
+        };
+
+        day = std::clamp(day, 0, days - 1);
+        dirty |= ImGui::SliderInt("Day", &day, 0, days - 1);
+        char date[16];
+        dateText(dateIndex.Dates()[day], date, sizeof(date));
+        ImGui::SameLine(); ImGui::Text("%s", date);
+        dirty |= ImGui::SliderInt("Days back", &rangeDays, 1, std::min(days, 1000));
+
+        static const char* fieldNames[(int)ScreenField::Count];
+        for (int f = 0; f < (int)ScreenField::Count; ++f)
+            fieldNames[f] = Screener::FieldName((ScreenField)f);
+        static const char* compareNames[] = { "above", "below" };
+
+        ImGui::SeparatorText("Conditions");
+        for (size_t i = 0; i < query.conditions.size(); ++i)
+        {
+            ScreenCondition& condition = query.conditions[i];
+            ImGui::PushID((int)i);
+            int field = (int)condition.field;
+            int compare = (int)condition.compare;
+            ImGui::SetNextItemWidth(100);
+            if (ImGui::Combo("##Field", &field, fieldNames, (int)ScreenField::Count))
+            {
+                condition.field = (ScreenField)field;
+                dirty = true;
+            }
+            ImGui::SameLine(); ImGui::SetNextItemWidth(80);
+            if (ImGui::Combo("##Compare", &compare, compareNames, IM_ARRAYSIZE(compareNames)))
+            {
+                condition.compare = (ScreenCompare)compare;
+                dirty = true;
+            }
+            // ratios are edited as percentages
+            const bool ratio = Screener::IsRatio(condition.field);
+            double threshold = ratio ? condition.threshold * 100.0 : condition.threshold;
+            ImGui::SameLine(); ImGui::SetNextItemWidth(100);
+            if (ImGui::InputDouble("##Threshold", &threshold, 0.0, 0.0, ratio ? "%.2f%%" : "%.2f"))
+            {
+                condition.threshold = ratio ? threshold / 100.0 : threshold;
+                dirty = true;
+            }
+            if (condition.field == ScreenField::VsHigh || condition.field == ScreenField::VsLow)
+            {
+                int lookback = (int)condition.lookback;
+                ImGui::SameLine(); ImGui::SetNextItemWidth(100);
+                if (ImGui::InputInt("rows##Lookback", &lookback))
+                {
+                    condition.lookback = (uint32_t)std::clamp(lookback, 1, 5000);
+                    dirty = true;
+                }
+            }
+            ImGui::SameLine();
+            const bool remove = ImGui::Button("Remove");
+            ImGui::PopID();
+            if (remove)
+            {
+                query.conditions.erase(query.conditions.begin() + i);
+                dirty = true;
+                break;
+            }
+        }
+        if (ImGui::Button("Add condition"))
+        {
+            query.conditions.push_back(ScreenCondition{});
+            dirty = true;
+        }
+
+        int sortBy = (int)query.sortBy;
+        ImGui::SetNextItemWidth(100);
+        if (ImGui::Combo("Sort by", &sortBy, fieldNames, (int)ScreenField::Count))
+        {
+            query.sortBy = (ScreenField)sortBy;
+            dirty = true;
+        }
+        ImGui::SameLine(); dirty |= ImGui::Checkbox("Descending", &query.descending);
+        int limit = (int)query.limit;
+        ImGui::SameLine(); ImGui::SetNextItemWidth(100);
+        if (ImGui::SliderInt("Per day", &limit, 1, 500))
+        {
+            query.limit = (size_t)limit;
+            dirty = true;
+        }
+
+        if (dirty)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            hits = rangeDays > 1
+                ? Screener::RunRange(market, dateIndex, (size_t)std::max(0, day + 1 - rangeDays), (size_t)day + 1, query)
+                : Screener::Run(market, dateIndex, (size_t)day, query);
+            runMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            dirty = false;
+        }
+        ImGui::Text("%zd hits over %zd symbols in %.2f ms", hits.size(), dateIndex.Symbols(), runMs);
+
+        if (ImGui::BeginTable("Hits", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            for (const char* column : { "Date", "Symbol", Screener::FieldName(query.sortBy) })
+                ImGui::TableSetupColumn(column);
+            ImGui::TableHeadersRow();
+
+            // newest day first, best first within a day
+            const bool ratio = Screener::IsRatio(query.sortBy);
+            for (size_t i = hits.size(); i-- > 0;)
+            {
+                size_t first = i;
+                while (first > 0 && hits[first - 1].day == hits[i].day)
+                    --first;
+                for (size_t k = first; k <= i; ++k)
+                {
+                    const ScreenHit& hit = hits[k];
+                    ImGui::TableNextRow();
+                    dateText(dateIndex.Dates()[hit.day], date, sizeof(date));
+                    ImGui::TableNextColumn(); ImGui::Text("%s", date);
+                    ImGui::TableNextColumn(); ImGui::Text("%s", market.Names()[hit.symbol]);
+                    ImGui::TableNextColumn(); ratio ? ImGui::Text("%+.2f%%", hit.value * 100.0) : ImGui::Text("%.2f", hit.value);
+                }
+                i = first;
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+void App::ShowBacktestWindow()
+{
+    PROFILE_SCOPE("App::ShowBacktestWindow");
+    if (ImGui::Begin("Backtest"))
+    {
+        if (loadProgress.Done() == false)
+        {
+            ImGui::Text("Waiting for every symbol to load");
+            ImGui::End();
+            return;
+        }
+
+        // moving average cross, swept over every fast/slow pair in the ranges
+        static int fastMin = 5, fastMax = 20;
+        static int slowMin = 50, slowMax = 200;
+        static int step = 5;
+        static int size = 100;
+        ImGui::DragIntRange2("Fast", &fastMin, &fastMax, 1.0f, 2, 200);
+        ImGui::DragIntRange2("Slow", &slowMin, &slowMax, 1.0f, 2, 400);
+        ImGui::SliderInt("Step", &step, 1, 50);
+        ImGui::InputInt("Size", &size);
+
+        const bool running = backtestRunning;
+        ImGui::BeginDisabled(running);
+        if (ImGui::Button("Run"))
+        {
+            BacktestConfig config;
+            config.sweep.clear();
+            for (int fast = fastMin; fast <= fastMax; fast += step)
+            {
+                for (int slow = slowMin; slow <= slowMax; slow += step)
+                {
+                    if (fast < slow)
+                        config.sweep.push_back(StrategyParams{ (uint32_t)fast, (uint32_t)slow, std::max(1, size) });
+                }
+            }
+
+            backtestRunning = true;
+            backtestThread = std::jthread([this, config] {
+                PROFILE_THREAD("Backtest");
+                backtestSummary = RunBacktest(market, config);
+                backtestRunning = false;
+                WakeMainLoop();
+            });
+        }
+        ImGui::EndDisabled();
+
+        if (running)
+        {
+            ImGui::SameLine(); ImGui::Text("Running...");
+        }
+        else if (backtestSummary.results.empty() == false)
+        {
+            ImGui::SameLine();
+            ImGui::Text("%zd runs on %u threads in %.2f s", backtestSummary.results.size(), backtestSummary.threads, backtestSummary.seconds);
+            if (backtestSummary.compressedSymbols != 0)
+            {
+                ImGui::SameLine(); ImGui::TextDisabled("%zd compressed symbols left out", backtestSummary.compressedSymbols);
+            }
+
+            std::vector<const BacktestParamSummary*> rows;
+            for (const BacktestParamSummary& summary : backtestSummary.perParams)
+                rows.push_back(&summary);
+            std::sort(rows.begin(), rows.end(), [](auto a, auto b) { return a->totalPnl > b->totalPnl; });
+
+            if (ImGui::BeginTable("Results", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
+            {
+                ImGui::TableSetupScrollFreeze(0, 1);
+                for (const char* column : { "Fast", "Slow", "PnL", "Profitable", "Worst DD", "Orders", "Trades", "Filled" })
+                    ImGui::TableSetupColumn(column);
+                ImGui::TableHeadersRow();
+
+                for (const BacktestParamSummary* row : rows)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::Text("%u", row->params.fastPeriod);
+                    ImGui::TableNextColumn(); ImGui::Text("%u", row->params.slowPeriod);
+                    ImGui::TableNextColumn(); ImGui::Text("%.0f", row->totalPnl);
+                    ImGui::TableNextColumn(); ImGui::Text("%zd / %zd", row->profitableSymbols, market.Count());
+                    ImGui::TableNextColumn(); ImGui::Text("%.0f", row->worstDrawdown);
+                    ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)row->orders);
+                    ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)row->trades);
+                    ImGui::TableNextColumn(); ImGui::Text("%.1f%%", row->requestedQuantity ? 100.0 * row->filledQuantity / row->requestedQuantity : 0.0);
+                }
+                ImGui::EndTable();
+            }
+        }
+    }
+    ImGui::End();
+}
+
+void App::ShowFetchWindow()
+{
+    PROFILE_SCOPE("App::ShowFetchWindow");
+    if (ImGui::Begin("Fetch"))
+    {
+        if (loadProgress.Done() == false)
+        {
+            ImGui::Text("Waiting for every symbol to load");
+            ImGui::End();
+            return;
+        }
+
+        // one request per symbol, {symbol} is replaced by its name
+        static char urlTemplate[512] = "http://localhost:8000/{symbol}.csv";
+        ImGui::InputText("URL", urlTemplate, sizeof(urlTemplate));
+
+        const size_t pending = fetcher.Pending();
+        ImGui::BeginDisabled(pending != 0);
+        if (ImGui::Button("Refresh all symbols"))
+        {
+            const std::string url = urlTemplate;
+            const size_t at = url.find("{symbol}");
+
+            fetchStatus = FetchStatus{};
+            fetchStatus.start = std::chrono::steady_clock::now();
+            fetchStatus.requested = at == std::string::npos ? 1 : market.Count();
+            for (size_t i = 0; i < fetchStatus.requested; ++i)
+            {
+                std::string symbolUrl = url;
+                if (at != std::string::npos)
+                    symbolUrl.replace(at, std::strlen("{symbol}"), market.Get((SymbolID)i).name);
+                fetcher.Fetch(std::move(symbolUrl));
+            }
+        }
+        ImGui::EndDisabled();
+
+        if (fetchStatus.requested != 0)
+        {
+            const size_t done = fetchStatus.succeeded + fetchStatus.failed;
+            char overlay[64];
+            std::snprintf(overlay, sizeof(overlay), "%zd / %zd requests", done, fetchStatus.requested);
+            ImGui::ProgressBar((float)done / (float)fetchStatus.requested, ImVec2(-FLT_MIN, 0), overlay);
+
+            if (pending == 0)
+                ImGui::Text("%zd failed, %.1f MB in %.0f ms", fetchStatus.failed, fetchStatus.bytes / (1024.0 * 1024.0), fetchStatus.seconds * 1000.0);
+            else if (backtestRunning)
+                ImGui::Text("Finished requests wait for the backtest");
+        }
+    }
+    ImGui::End();
+}
+
+namespace
+{
+    // same name, same color in every view and every frame
+    ImU32 ScopeColor(const char* name)
+    {
+        uint32_t hash = 2166136261u;
+        for (const char* c = name; *c; ++c)
+            hash = (hash ^ (uint8_t)*c) * 16777619u;
+        return IM_COL32(90 + hash % 140, 90 + (hash >> 8) % 140, 90 + (hash >> 16) % 140, 255);
+    }
+
+    // scopes as bars stacked by depth over [from, to), hovering one shows its numbers
+    void DrawTimeline(const char* id, const std::vector<ProfileEvent>& events, uint64_t from, uint64_t to, uint32_t maxDepth)
+    {
+        const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+        const ImVec2 size(std::max(ImGui::GetContentRegionAvail().x, 1.0f), rowHeight * (maxDepth + 1));
+        ImGui::InvisibleButton(id, size);
+        const bool hovered = ImGui::IsItemHovered();
+        const ImVec2 mouse = ImGui::GetMousePos();
+
+        const double scale = size.x / (double)std::max<uint64_t>(to - from, 1);
+        const ProfileEvent* hoveredEvent = nullptr;
+
+        ImDrawList* draw = ImGui::GetWindowDrawList();
+        draw->PushClipRect(origin, ImVec2(origin.x + size.x, origin.y + size.y), true);
+        for (const ProfileEvent& e : events)
+        {
+            if (e.end < from || e.start >= to || e.depth > maxDepth)
+                continue;
+
+            const float x0 = origin.x + (float)(((double)e.start - (double)from) * scale);
+            // sub pixel scopes stay visible as a one pixel line
+            const float x1 = std::max(x0 + 1.0f, origin.x + (float)(((double)e.end - (double)from) * scale));
+            const float y0 = origin.y + e.depth * rowHeight;
+            const ImVec2 min(x0, y0);
+            const ImVec2 max(x1, y0 + rowHeight - 1.0f);
+            draw->AddRectFilled(min, max, ScopeColor(e.name));
+            if (x1 - x0 > 24.0f)
+            {
+                draw->PushClipRect(min, max, true);
+                draw->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32(0, 0, 0, 255), e.name);
+                draw->PopClipRect();
+            }
+
+            if (hovered && mouse.x >= x0 && mouse.x < x1 && mouse.y >= min.y && mouse.y < max.y)
+                hoveredEvent = &e;
+        }
+        draw->PopClipRect();
+
+        if (hoveredEvent)
+        {
+            ImGui::SetTooltip("%s\n%.3f ms\n%u allocations, %llu bytes", hoveredEvent->name, (hoveredEvent->end - hoveredEvent->start) / 1e6,
+                hoveredEvent->allocations, (unsigned long long)hoveredEvent->allocatedBytes);
+        }
+    }
+
+    double Percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+        return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+    }
+
+    struct ScopeStats
+    {
+        std::string_view name;
+        std::vector<double> ms;
+        double totalMs{};
+        uint64_t allocations{};
+        uint64_t allocatedBytes{};
+    };
+}
+
+void App::ShowProfilerWindow()
+{
+    if (ImGui::Begin("Profiler"))
+    {
+        static bool enabled = true;
+        if (ImGui::Checkbox("Enabled", &enabled))
+            Profiler::SetEnabled(enabled);
+        ImGui::SameLine();
+        static bool paused = false;
+        ImGui::Checkbox("Pause", &paused);
+        ImGui::SameLine();
+        static bool slowest = true;
+        ImGui::Checkbox("Show slowest frame", &slowest);
+        static float windowSeconds = 2.0f;
+        ImGui::SliderFloat("Window (s)", &windowSeconds, 0.5f, 10.0f, "%.1f");
+
+        // copying every ring is not free, the view refreshes a few times per second
+        static std::vector<ProfileThread> threads;
+        static std::vector<const ProfileEvent*> frames;
+        static std::vector<double> frameMs;
+        static std::vector<double> sortedFrameMs;
+        static std::vector<ScopeStats> scopes;
+        static uint64_t now = 0;
+        static double lastSnapshot = -1.0;
+        if (paused == false && ImGui::GetTime() - lastSnapshot > 0.25)
+        {
+            lastSnapshot = ImGui::GetTime();
+            now = Profiler::Now();
+            const uint64_t windowNs = (uint64_t)(windowSeconds * 1e9);
+            Profiler::Snapshot(now > windowNs ? now - windowNs : 0, threads);
+
+            frames.clear();
+            frameMs.clear();
+            std::unordered_map<std::string_view, size_t> scopeIndex;
+            scopes.clear();
+            for (const ProfileThread& thread : threads)
+            {
+                for (const ProfileEvent& e : thread.events)
+                {
+                    const double ms = (e.end - e.start) / 1e6;
+                    if (thread.name == "Main" && std::strcmp(e.name, "Frame") == 0)
+                    {
+                        frames.push_back(&e);
+                        frameMs.push_back(ms);
+                    }
+
+                    auto [it, added] = scopeIndex.try_emplace(e.name, scopes.size());
+                    if (added)
+                    {
+                        scopes.emplace_back();
+                        scopes.back().name = e.name;
+                    }
+                    ScopeStats& stats = scopes[it->second];
+                    stats.ms.push_back(ms);
+                    stats.totalMs += ms;
+                    stats.allocations += e.allocations;
+                    stats.allocatedBytes += e.allocatedBytes;
+                }
+            }
+            for (ScopeStats& stats : scopes)
+                std::sort(stats.ms.begin(), stats.ms.end());
+            std::sort(scopes.begin(), scopes.end(), [](const ScopeStats& a, const ScopeStats& b) { return a.totalMs > b.totalMs; });
+
+            sortedFrameMs = frameMs;
+            std::sort(sortedFrameMs.begin(), sortedFrameMs.end());
+        }
+
+        ImGui::Text("%zd frames  p50 %.2f ms  p95 %.2f ms  p99 %.2f ms  max %.2f ms", frameMs.size(),
+            Percentile(sortedFrameMs, 0.50), Percentile(sortedFrameMs, 0.95), Percentile(sortedFrameMs, 0.99), sortedFrameMs.empty() ? 0.0 : sortedFrameMs.back());
+
+        // clicking a frame in the plot pins it in the flame view until slowest is ticked again
+        static uint64_t pinnedStart = 0;
+        if (ImPlot::BeginPlot("##FrameTimes", ImVec2(-1, 120), ImPlotFlags_NoLegend | ImPlotFlags_NoMouseText))
+        {
+            ImPlot::SetupAxes(nullptr, "ms", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot::PlotLine("Frame", frameMs.data(), (int)frameMs.size());
+            if (ImPlot::IsPlotHovered() && ImGui::IsMouseClicked(0) && frames.empty() == false)
+            {
+                const double x = std::round(ImPlot::GetPlotMousePos().x);
+                const size_t index = (size_t)std::clamp(x, 0.0, (double)frames.size() - 1.0);
+                pinnedStart = frames[index]->start;
+                slowest = false;
+            }
             ImPlot::EndPlot();
         }
 
+        const ProfileEvent* frame = nullptr;
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            if (slowest ? (frame == nullptr || frameMs[i] > (frame->end - frame->start) / 1e6) : frames[i]->start == pinnedStart)
+                frame = frames[i];
+        }
+
+        ImGui::SeparatorText("Frame");
+        if (frame)
+        {
+            ImGui::Text("%.3f ms, %u allocations", (frame->end - frame->start) / 1e6, frame->allocations);
+            for (const ProfileThread& thread : threads)
+            {
+                if (thread.name == "Main")
+                    DrawTimeline("##Flame", thread.events, frame->start, frame->end, 6);
+            }
+        }
+        else
+        {
+            ImGui::TextDisabled("%s", slowest ? "No frames recorded" : "Pinned frame left the window");
+        }
+
+        ImGui::SeparatorText("Threads");
+        const uint64_t windowNs = (uint64_t)(windowSeconds * 1e9);
+        for (size_t t = 0; t < threads.size(); ++t)
+        {
+            ImGui::TextUnformatted(threads[t].name.c_str());
+            ImGui::PushID((int)t);
+            DrawTimeline("##Thread", threads[t].events, now > windowNs ? now - windowNs : 0, now, 2);
+            ImGui::PopID();
+        }
+
+        ImGui::SeparatorText("Scopes");
+        if (ImGui::BeginTable("Scopes", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 300)))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            for (const char* column : { "Scope", "Calls", "Total ms", "p50 ms", "p95 ms", "p99 ms", "Allocs/call", "KB/call" })
+                ImGui::TableSetupColumn(column);
+            ImGui::TableHeadersRow();
+
+            // allocation counts include nested scopes
+            for (const ScopeStats& stats : scopes)
+            {
+                const double calls = (double)stats.ms.size();
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::Text("%.*s", (int)stats.name.size(), stats.name.data());
+                ImGui::TableNextColumn(); ImGui::Text("%zd", stats.ms.size());
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.totalMs);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", Percentile(stats.ms, 0.50));
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", Percentile(stats.ms, 0.95));
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", Percentile(stats.ms, 0.99));
+                ImGui::TableNextColumn(); ImGui::Text("%.1f", stats.allocations / calls);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.allocatedBytes / calls / 1024.0);
+            }
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+void App::ShowMemoryWindow()
+{
+    if (ImGui::Begin("Memory"))
+    {
+        constexpr size_t TAGS = (size_t)MemoryTag::Count;
+        constexpr size_t HISTORY = 240;
+
+        // live bytes sampled a few times per second, the last minute is kept
+        static std::vector<double> history[TAGS];
+        static double lastSample = -1.0;
+        if (ImGui::GetTime() - lastSample > 0.25)
+        {
+            lastSample = ImGui::GetTime();
+            for (size_t t = 0; t < TAGS; ++t)
+            {
+                if (history[t].size() == HISTORY)
+                    history[t].erase(history[t].begin());
+                history[t].push_back(Memory::Stats((MemoryTag)t).liveBytes / (1024.0 * 1024.0));
+            }
+        }
+
+        if (ImGui::Button("Reset peaks"))
+        {
+            for (size_t t = 0; t < TAGS; ++t)
+                Memory::Tracked((MemoryTag)t)->ResetPeak();
+        }
+
+        // bytes held from the system, pool and monotonic books include their unused capacity
+        if (ImGui::BeginTable("Tags", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            for (const char* column : { "Tag", "Live MB", "Peak MB", "Allocations", "Frees" })
+                ImGui::TableSetupColumn(column);
+            ImGui::TableHeadersRow();
+
+            for (size_t t = 0; t < TAGS; ++t)
+            {
+                const MemoryStats stats = Memory::Stats((MemoryTag)t);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::Text("%s", Memory::TagName((MemoryTag)t));
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.liveBytes / (1024.0 * 1024.0));
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.peakBytes / (1024.0 * 1024.0));
+                ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)stats.allocations);
+                ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)stats.deallocations);
+            }
+            ImGui::EndTable();
+        }
+
+        // blocks of 64 KB and up are mapped by the placement layer once a policy is set,
+        // asking the kernel where their pages are walks all of them, so only on request
+        static PlacementStats placed[TAGS];
+        static bool placedValid = false;
+        if (ImGui::Button("Query placement"))
+        {
+            for (size_t t = 0; t < TAGS; ++t)
+                placed[t] = Memory::Placement((MemoryTag)t);
+            placedValid = true;
+        }
+        ImGui::SameLine();
+        constexpr const char* pageNames[] = { "default pages", "transparent huge pages", "explicit huge pages" };
+        ImGui::Text("%s%s%s, %u nodes", pageNames[(size_t)placement.pages], placement.localNode ? ", local node" : "",
+            placement.prefault ? ", prefaulted" : "", Memory::NodeCount());
+
+        const size_t nodes = std::min<size_t>(Memory::NodeCount(), PlacementStats::MAX_NODES);
+        if (placedValid && ImGui::BeginTable("Placement", (int)(nodes + 5), ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            for (const char* column : { "Tag", "Blocks", "Mapped MB", "Huge MB" })
+                ImGui::TableSetupColumn(column);
+            for (size_t node = 0; node < nodes; ++node)
+            {
+                char name[32];
+                std::snprintf(name, sizeof(name), "Node %zu MB", node);
+                ImGui::TableSetupColumn(name);
+            }
+            ImGui::TableSetupColumn("Not resident MB");
+            ImGui::TableHeadersRow();
+
+            for (size_t t = 0; t < TAGS; ++t)
+            {
+                const PlacementStats& stats = placed[t];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::Text("%s", Memory::TagName((MemoryTag)t));
+                ImGui::TableNextColumn(); ImGui::Text("%zu", stats.blocks);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.mappedBytes / (1024.0 * 1024.0));
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.hugeBytes / (1024.0 * 1024.0));
+                for (size_t node = 0; node < nodes; ++node)
+                {
+                    ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.nodeBytes[node] / (1024.0 * 1024.0));
+                }
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.otherBytes / (1024.0 * 1024.0));
+            }
+            ImGui::EndTable();
+        }
+
+        if (ImPlot::BeginPlot("##LiveBytes", ImVec2(-1, 200)))
+        {
+            ImPlot::SetupAxes("samples", "MB", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            for (size_t t = 0; t < TAGS; ++t)
+                ImPlot::PlotLine(Memory::TagName((MemoryTag)t), history[t].data(), (int)history[t].size());
+            ImPlot::EndPlot();
+        }
     }
     ImGui::End();
 }
 
+void App::ShowMarketDataWindow()
+{
+    PROFILE_SCOPE("App::ShowMarketDataWindow");
+    constexpr size_t maxTrades = 64;
 
-void App::PlotCandlestick(const char* label_id, const double* xs, const double* opens, const double* closes, const double* lows, const double* highs, int count, bool tooltip, float width_percent, ImVec4 bullCol, ImVec4 bearCol) {
+    if (busSubscriber->IsOpen() == false)
+    {
+        // engine may start after the viewer, retry once a second
+        static double lastAttempt = 0.0;
+        if (ImGui::GetTime() - lastAttempt > 1.0)
+        {
+            lastAttempt = ImGui::GetTime();
+            busSubscriber = std::make_unique<MarketDataSubscriber>(BUS_DEFAULT_NAME);
+        }
+    }
+
+    BusMessage msg;
+    MarketDataSubscriber::Result result;
+    while ((result = busSubscriber->Poll(msg)) != MarketDataSubscriber::Result::Empty
+        && result != MarketDataSubscriber::Result::Closed)
+    {
+        if (result == MarketDataSubscriber::Result::Resynced)
+        {
+            busTrades.clear();
+        }
+
+        if (msg.type == BusMessage::Type::Depth)
+        {
+            busDepth = msg.depth;
+            depthHistory.Record(Profiler::Now(), busDepth.bids, busDepth.numBids, busDepth.asks, busDepth.numAsks);
+        }
+        else
+        {
+            const BusTrade& trade = msg.trade;
+            tradeTape.Append(trade.time / 1e9, trade.aggressor == Side::Buy ? trade.askPrice : trade.bidPrice, trade.quantity, trade.aggressor);
+            busTrades.push_front(trade);
+            if (busTrades.size() > maxTrades)
+                busTrades.pop_back();
+        }
+    }
+
+    if (ImGui::Begin("Market Data"))
+    {
+        if (busSubscriber->IsOpen() == false)
+        {
+            ImGui::Text("Waiting for engine on %s", BUS_DEFAULT_NAME);
+        }
+        else
+        {
+            ImGui::Text("Sequence %llu  Overruns %llu", (unsigned long long)busSubscriber->NextSequence(), (unsigned long long)busSubscriber->Overruns());
+
+            if (ImGui::BeginTable("Depth", 2, ImGuiTableFlags_Borders))
+            {
+                ImGui::TableSetupColumn("Price");
+                ImGui::TableSetupColumn("Quantity");
+                ImGui::TableHeadersRow();
+
+                for (uint32_t i = busDepth.numAsks; i-- > 0;)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::TextColored(ImVec4(0.853f, 0.050f, 0.310f, 1.000f), "%d", busDepth.asks[i].price);
+                    ImGui::TableNextColumn(); ImGui::Text("%u", busDepth.asks[i].quantity);
+                }
+                for (uint32_t i = 0; i < busDepth.numBids; ++i)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::TextColored(ImVec4(0.000f, 1.000f, 0.441f, 1.000f), "%d", busDepth.bids[i].price);
+                    ImGui::TableNextColumn(); ImGui::Text("%u", busDepth.bids[i].quantity);
+                }
+                ImGui::EndTable();
+            }
+
+            ImGui::SeparatorText("Trades");
+            for (const BusTrade& trade : busTrades)
+            {
+                const bool buy = trade.aggressor == Side::Buy;
+                ImGui::TextColored(buy ? ImVec4(0.000f, 1.000f, 0.441f, 1.000f) : ImVec4(0.853f, 0.050f, 0.310f, 1.000f),
+                    "%u @ %d", trade.quantity, buy ? trade.askPrice : trade.bidPrice);
+            }
+
+            ImGui::SeparatorText("Tape");
+            ImGui::Text("%zd trades  buy %llu  sell %llu", tradeTape.Size(),
+                (unsigned long long)tradeTape.Volume(Side::Buy), (unsigned long long)tradeTape.Volume(Side::Sell));
+            static int tapeInterval = 0;
+            if (tradeTape.Intervals() != 0)
+            {
+                tapeInterval = std::min(tapeInterval, (int)tradeTape.Intervals() - 1);
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(120);
+                if (ImGui::BeginCombo("##TapeInterval", tradeTape.Bars(tapeInterval).name.c_str()))
+                {
+                    for (int i = 0; i < (int)tradeTape.Intervals(); ++i)
+                        if (ImGui::Selectable(tradeTape.Bars(i).name.c_str(), i == tapeInterval))
+                            tapeInterval = i;
+                    ImGui::EndCombo();
+                }
+
+                // bars are kept up to date by every fill, plotting never touches the tape itself
+                const DataStore& bars = tradeTape.Bars(tapeInterval);
+                if (bars.size() != 0 && ImPlot::BeginPlot("##TapeBars", ImVec2(-1, 250)))
+                {
+                    static ImVec4 bullCol = ImVec4(0.000f, 1.000f, 0.441f, 1.000f);
+                    static ImVec4 bearCol = ImVec4(0.853f, 0.050f, 0.310f, 1.000f);
+                    ImPlot::SetupAxes("Time", "Price", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_RangeFit);
+                    ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Time);
+                    App::PlotCandlestick(bars.name.c_str(), bars, false, 0.25f, bullCol, bearCol); // the tooltip snaps to hours
+                    ImPlot::EndPlot();
+                }
+            }
+
+            ImGui::SeparatorText("Depth history");
+            ImGui::Text("%zd snapshots in a %.1f MB ring", depthHistory.Size(), depthHistory.CapacityBytes() / (1024.0 * 1024.0));
+
+            // price x time grid rebuilt a few times per second, each cell holds the most
+            // liquidity seen at its prices during its slice of time
+            constexpr int HEAT_ROWS = 200;
+            constexpr int HEAT_COLUMNS = 400;
+            static std::vector<double> heat(HEAT_ROWS * HEAT_COLUMNS);
+            static std::vector<double> columnSeconds(HEAT_COLUMNS);
+            static std::vector<double> bestBids(HEAT_COLUMNS);
+            static std::vector<double> bestAsks(HEAT_COLUMNS);
+            static double heatMax = 1.0, priceLow = 0.0, priceHigh = 1.0, spanSeconds = 1.0;
+            static double lastBuild = -1.0;
+            if (ImGui::GetTime() - lastBuild > 0.25 && depthHistory.Size() != 0)
+            {
+                lastBuild = ImGui::GetTime();
+
+                uint64_t first = UINT64_MAX, last = 0;
+                Price low = INT32_MAX, high = INT32_MIN;
+                depthHistory.ForEach([&](const DepthSnapshot& snapshot) {
+                    first = std::min(snapshot.time, first);
+                    last = std::max(snapshot.time, last);
+                    for (const DepthLevels* side : { &snapshot.bids, &snapshot.asks })
+                    {
+                        for (uint32_t i = 0; i < side->count; ++i)
+                        {
+                            low = std::min(side->levels[i].price, low);
+                            high = std::max(side->levels[i].price, high);
+                        }
+                    }
+                });
+                if (low > high)
+                    low = high = 0;
+
+                priceLow = low;
+                priceHigh = high + 1.0;
+                const double ticksPerRow = std::max(1.0, (priceHigh - priceLow) / HEAT_ROWS);
+                const double span = (double)std::max<uint64_t>(last - first, 1);
+                spanSeconds = span / 1e9;
+
+                std::fill(heat.begin(), heat.end(), 0.0);
+                std::fill(bestBids.begin(), bestBids.end(), NAN);
+                std::fill(bestAsks.begin(), bestAsks.end(), NAN);
+                auto addLevel = [&](int column, const LevelInfo& level) {
+                    // row 0 is drawn at the top, so it holds the highest prices
+                    const int row = std::clamp((int)((priceHigh - level.price - 1) / ticksPerRow), 0, HEAT_ROWS - 1);
+                    double& cell = heat[row * HEAT_COLUMNS + column];
+                    cell = std::max(cell, (double)level.quantity);
+                };
+                depthHistory.ForEach([&](const DepthSnapshot& snapshot) {
+                    const int column = std::min(HEAT_COLUMNS - 1, (int)((snapshot.time - first) / span * HEAT_COLUMNS));
+                    for (uint32_t i = 0; i < snapshot.bids.count; ++i)
+                        addLevel(column, snapshot.bids.levels[i]);
+                    for (uint32_t i = 0; i < snapshot.asks.count; ++i)
+                        addLevel(column, snapshot.asks.levels[i]);
+                    bestBids[column] = snapshot.bids.count ? snapshot.bids.levels[0].price + 0.5 : NAN;
+                    bestAsks[column] = snapshot.asks.count ? snapshot.asks.levels[0].price + 0.5 : NAN;
+                });
+
+                heatMax = std::max(1.0, *std::max_element(heat.begin(), heat.end()));
+                for (int c = 0; c < HEAT_COLUMNS; ++c)
+                    columnSeconds[c] = -spanSeconds + (c + 0.5) * spanSeconds / HEAT_COLUMNS;
+            }
+
+            ImPlot::PushColormap(ImPlotColormap_Hot);
+            if (ImPlot::BeginPlot("##DepthHeatmap", ImVec2(-1, 300)))
+            {
+                ImPlot::SetupAxes("seconds", "price", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+                ImPlot::PlotHeatmap("##Liquidity", heat.data(), HEAT_ROWS, HEAT_COLUMNS, 0.0, heatMax, nullptr,
+                    ImPlotPoint(-spanSeconds, priceLow), ImPlotPoint(0.0, priceHigh));
+                ImPlot::PlotLine("Best bid", columnSeconds.data(), bestBids.data(), HEAT_COLUMNS, ImPlotLineFlags_SkipNaN);
+                ImPlot::PlotLine("Best ask", columnSeconds.data(), bestAsks.data(), HEAT_COLUMNS, ImPlotLineFlags_SkipNaN);
+                ImPlot::EndPlot();
+            }
+            ImPlot::PopColormap();
+        }
+    }
+    ImGui::End();
+}
+
+void App::PlotCompressedHistory(const DataStore& ds, bool tooltip)
+{
+    PROFILE_SCOPE("App::PlotCompressedHistory");
+    const CompressedStore& packed = *ds.packed;
+    ImGui::TextDisabled("%s is compressed, decompress it for indicators and resampled bars", ds.name.c_str());
+    if (packed.size() == 0)
+        return;
+
+    // blocks under the x limits decoded by an earlier frame, reused while the view stays inside them
+    static std::shared_ptr<const CompressedStore> windowSource;
+    static DataStore window;
+    static size_t windowFirst = 0, windowLast = 0;
+
+    const double firstDate = packed.date.GetBlock(0).first;
+    const double lastDate = packed.date.GetBlock(packed.date.Blocks() - 1).maximum;
+    if (ImPlot::BeginPlot("Compressed Chart", ImVec2(-1, 0))) {
+        ImPlot::SetupAxes("Date", "Price", 0, ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_RangeFit);
+        ImPlot::SetupAxesLimits(firstDate, lastDate, ds.minimum, ds.maximum);
+        ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Time);
+        ImPlot::SetupAxisLimitsConstraints(ImAxis_X1, firstDate, lastDate);
+        double oneDay = 60 * 60 * 24 * 1;
+        ImPlot::SetupAxisZoomConstraints(ImAxis_X1, oneDay*5, lastDate - firstDate);
+        ImPlot::SetupAxisFormat(ImAxis_Y1, "$%.0f");
+
+        // one row either side, so candles cut by the plot edge are still drawn
+        const ImPlotRect limits = ImPlot::GetPlotLimits();
+        const size_t lower = packed.date.LowerBound(limits.X.Min);
+        const size_t first = lower > 0 ? lower - 1 : 0;
+        const size_t last = std::min(packed.date.UpperBound(limits.X.Max) + 1, packed.size());
+        if (windowSource != ds.packed || first < windowFirst || last > windowLast)
+        {
+            constexpr size_t BLOCK_ROWS = CompressedColumn::BLOCK_ROWS;
+            windowFirst = first / BLOCK_ROWS * BLOCK_ROWS;
+            windowLast = std::min((last + BLOCK_ROWS - 1) / BLOCK_ROWS * BLOCK_ROWS, packed.size());
+            packed.Decode(windowFirst, windowLast, window);
+            windowSource = ds.packed;
+        }
+
+        static ImVec4 bullCol = ImVec4(0.000f, 1.000f, 0.441f, 1.000f);
+        static ImVec4 bearCol = ImVec4(0.853f, 0.050f, 0.310f, 1.000f);
+        App::PlotCandlestick(ds.name.c_str(), window, tooltip, 0.25f, bullCol, bearCol);
+        ImPlot::EndPlot();
+    }
+}
+
+void App::PlotCandlestick(const char* label_id, const DataStore& ds, bool tooltip, float width_percent, ImVec4 bullCol, ImVec4 bearCol) {
+    PROFILE_SCOPE("App::PlotCandlestick");
+
+    const double* xs     = ds.date.data();
+    const double* opens  = ds.open.data();
+    const double* closes = ds.close.data();
+    const double* lows   = ds.low.data();
+    const double* highs  = ds.high.data();
+    const int count      = (int)ds.size();
 
     // get ImGui window DrawList
     ImDrawList* draw_list = ImPlot::GetPlotDrawList();
@@ -466,7 +1876,7 @@ void App::PlotCandlestick(const char* label_id, const double* xs, const double*
         int idx = BinarySearch(xs, 0, count - 1, mouse.x);
         //int idx = 0;
         // render tool tip (won't be affected by plot clip rect)
-        if (idx != -1) {
+        if (idx != -1 && idx < count) {
             ImGui::BeginTooltip();
             char buff[32];
             ImPlot::FormatDate(ImPlotTime::FromDouble(xs[idx]),buff,32,ImPlotDateFmt_DayMoYr,ImPlot::GetStyle().UseISO8601);
@@ -483,47 +1893,62 @@ void App::PlotCandlestick(const char* label_id, const double* xs, const double*
     if (ImPlot::BeginItem(label_id)) {
         // override legend icon color
         ImPlot::GetCurrentItem()->Color = IM_COL32(64,64,64,255);
-        // fit data if requested
-        if (ImPlot::FitThisFrame()) {
-            for (int i = 0; i < count; ++i) {
-                ImPlot::FitPoint(ImPlotPoint(xs[i], lows[i]));
-                ImPlot::FitPoint(ImPlotPoint(xs[i], highs[i]));
-            }
+
+        // only the candles inside the x limits (plus one candle either side) are touched
+        const ImPlotRect limits = ImPlot::GetPlotLimits();
+        const int first = int(std::lower_bound(xs, xs + count, limits.X.Min - half_width) - xs);
+        const int last  = int(std::upper_bound(xs, xs + count, limits.X.Max + half_width) - xs);
+
+        // fit data if requested, the extents are precomputed so this is O(blocks) not O(candles)
+        if (ImPlot::FitThisFrame() && first < last) {
+            double low, high;
+            ds.RangeExtent(first, last, low, high);
+            ImPlot::FitPoint(ImPlotPoint(xs[first], low));
+            ImPlot::FitPoint(ImPlotPoint(xs[last - 1], high));
         }
+
+        const float  plot_width     = std::max(1.0f, ImPlot::GetPlotSize().x);
+        const double units_per_px   = limits.X.Size() / plot_width;
+        const double candle_spacing = last - first > 1 ? (xs[last - 1] - xs[first]) / (last - first - 1) : units_per_px;
+
         // render data
-        for (int i = 0; i < count; ++i) {
-            ImVec2 open_pos  = ImPlot::PlotToPixels(xs[i] - half_width, opens[i]);
-            ImVec2 close_pos = ImPlot::PlotToPixels(xs[i] + half_width, closes[i]);
-            ImVec2 low_pos   = ImPlot::PlotToPixels(xs[i], lows[i]);
-            ImVec2 high_pos  = ImPlot::PlotToPixels(xs[i], highs[i]);
-            ImU32 color      = ImGui::GetColorU32(opens[i] > closes[i] ? bearCol : bullCol);
-            draw_list->AddLine(low_pos, high_pos, color);
-            draw_list->AddRectFilled(open_pos, close_pos, color);
+        if (candle_spacing >= units_per_px * 2.0) {
+            for (int i = first; i < last; ++i) {
+                ImVec2 open_pos  = ImPlot::PlotToPixels(xs[i] - half_width, opens[i]);
+                ImVec2 close_pos = ImPlot::PlotToPixels(xs[i] + half_width, closes[i]);
+                ImVec2 low_pos   = ImPlot::PlotToPixels(xs[i], lows[i]);
+                ImVec2 high_pos  = ImPlot::PlotToPixels(xs[i], highs[i]);
+                ImU32 color      = ImGui::GetColorU32(opens[i] > closes[i] ? bearCol : bullCol);
+                draw_list->AddLine(low_pos, high_pos, color);
+                draw_list->AddRectFilled(open_pos, close_pos, color);
+            }
+        }
+        else {
+            // several candles share a pixel column, merge each column into one OHLC bar
+            // so the cost follows the plot width instead of the history length
+            int i = first;
+            while (i < last) {
+                const double column_end = limits.X.Min + (std::floor((xs[i] - limits.X.Min) / units_per_px) + 1.0) * units_per_px;
+                const int end = std::max(i + 1, int(std::lower_bound(xs + i, xs + last, column_end) - xs));
+
+                double low, high;
+                ds.RangeExtent(i, end, low, high);
+                const double open  = opens[i];
+                const double close = closes[end - 1];
+
+                ImVec2 open_pos  = ImPlot::PlotToPixels(xs[i], open);
+                ImVec2 close_pos = ImPlot::PlotToPixels(xs[i], close);
+                ImVec2 low_pos   = ImPlot::PlotToPixels(xs[i], low);
+                ImVec2 high_pos  = ImPlot::PlotToPixels(xs[i], high);
+                ImU32 color      = ImGui::GetColorU32(open > close ? bearCol : bullCol);
+                draw_list->AddLine(low_pos, high_pos, color);
+                draw_list->AddRectFilled(ImVec2(open_pos.x - 0.5f, open_pos.y), ImVec2(close_pos.x + 0.5f, close_pos.y), color);
+
+                i = end;
+            }
         }
 
         // end plot item
         ImPlot::EndItem();
     }
 }
-
-void DataFrame::Print()
-{
-    printf("%zd- %lf,%lf,%lf,%lf,%lf \n", (size_t)date, open,
-        close,
-        high,
-        low,
-        volume);
-}
-
-void DataStore::PushData(const DataFrame& df)
-{
-    date.push_back(df.date);
-    open.push_back(df.open);
-    close.push_back(df.close);
-    high.push_back(df.high);
-    low.push_back(df.low);
-    volume.push_back(df.volume);
-
-    maximum = std::max(df.high, maximum);
-    minimum = std::min(df.low , minimum);
-}
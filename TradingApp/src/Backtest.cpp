@@ -0,0 +1,162 @@
+#include "Backtest.h"
+#include "Indicators.h"
+#include "Orderbook.h"
+#include "Profiler.h"
+#include "TaskPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+	Price ToTicks(double price, double tickSize)
+	{
+		return (Price)std::llround(price / tickSize);
+	}
+
+	BacktestResult RunTask(const DataStore& bars, const StrategyParams& params, const BacktestConfig& config)
+	{
+		PROFILE_SCOPE("Backtest::RunTask");
+		BacktestResult result;
+
+		std::unique_ptr<Strategy> strategy = config.factory(params);
+		strategy->Begin(bars);
+
+		const LiquidityModel& liquidity = config.liquidity;
+		const Price levels = (Price)std::max<uint32_t>(liquidity.levels, 1);
+
+		OrderBook book(OrderBookMode::SingleThreaded, AllocatorKind::Pool);
+		OrderID nextID = 1;
+
+		int64_t position = 0;
+		double cash = 0.0;
+		double equity = 0.0;
+		double peak = 0.0;
+
+		for (size_t i = 0; i < bars.size(); ++i)
+		{
+			const Price open = ToTicks(bars.open[i], liquidity.tickSize);
+			const Price high = std::max(open, ToTicks(bars.high[i], liquidity.tickSize));
+			const Price low = std::min(open, ToTicks(bars.low[i], liquidity.tickSize));
+
+			// ladders from the open out to the bar's high and low, gone again at the bar's end
+			const Price askStep = std::max<Price>(1, (high - open) / levels);
+			const Price bidStep = std::max<Price>(1, (open - low) / levels);
+			const Quantity perLevel = (Quantity)std::max(1.0, bars.volume[i] * liquidity.participation / (2.0 * levels));
+			for (Price k = 1; k <= levels; ++k)
+			{
+				book.AddOrder(book.CreateOrder(OrderType::GoodForDay, nextID++, Side::Sell, open + k * askStep, perLevel));
+				book.AddOrder(book.CreateOrder(OrderType::GoodForDay, nextID++, Side::Buy, open - k * bidStep, perLevel));
+			}
+
+			const int64_t delta = strategy->TargetPosition(BarContext{ bars, i, position }) - position;
+			if (delta != 0)
+			{
+				const Side side = delta > 0 ? Side::Buy : Side::Sell;
+				const Price limit = delta > 0 ? open + levels * askStep : open - levels * bidStep;
+				const Quantity quantity = (Quantity)std::abs(delta);
+
+				++result.orders;
+				result.requestedQuantity += quantity;
+
+				for (const Trade& trade : book.AddOrder(book.CreateOrder(OrderType::FillAndKill, nextID++, side, limit, quantity)))
+				{
+					// fills happen at the resting synthetic order's price
+					const TradeInfo& resting = side == Side::Buy ? trade.askTrade : trade.bidTrade;
+					const int64_t signedQuantity = side == Side::Buy ? (int64_t)resting.quantity : -(int64_t)resting.quantity;
+					position += signedQuantity;
+					cash -= signedQuantity * (resting.price * liquidity.tickSize);
+
+					++result.trades;
+					result.filledQuantity += resting.quantity;
+				}
+			}
+
+			book.CancelGoodForDay();
+
+			equity = cash + position * bars.close[i];
+			peak = std::max(peak, equity);
+			result.maxDrawdown = std::max(result.maxDrawdown, peak - equity);
+		}
+
+		result.pnl = equity;
+		return result;
+	}
+}
+
+void MovingAverageCross::Begin(const DataStore& bars)
+{
+	fast.resize(bars.size());
+	slow.resize(bars.size());
+	Indicators::Sma(bars.close.data(), bars.size(), 0, std::max<uint32_t>(params.fastPeriod, 1), fast.data());
+	Indicators::Sma(bars.close.data(), bars.size(), 0, std::max<uint32_t>(params.slowPeriod, 1), slow.data());
+}
+
+int64_t MovingAverageCross::TargetPosition(const BarContext& context)
+{
+	// decide on the previous close, the current bar has only opened
+	if (context.index == 0)
+		return 0;
+
+	const double f = fast[context.index - 1];
+	const double s = slow[context.index - 1];
+	if (std::isnan(f) || std::isnan(s))
+		return 0;
+	return f > s ? params.size : -params.size;
+}
+
+BacktestSummary RunBacktest(const MarketData& data, const BacktestConfig& config, unsigned numThreads)
+{
+	BacktestSummary summary;
+	if (numThreads == 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	summary.threads = numThreads;
+
+	std::vector<SymbolID> replayed;
+	replayed.reserve(data.Count());
+	for (SymbolID id = 0; id < (SymbolID)data.Count(); ++id)
+	{
+		if (data.Get(id).IsCompressed())
+			++summary.compressedSymbols;
+		else
+			replayed.push_back(id);
+	}
+
+	const size_t symbols = replayed.size();
+	const size_t tasks = symbols * config.sweep.size();
+	summary.results.resize(tasks);
+
+	auto start = std::chrono::steady_clock::now();
+
+	RunTasks(tasks, numThreads, [&](size_t task, unsigned) {
+		const SymbolID symbol = replayed[task % symbols];
+		const size_t paramIndex = task / symbols;
+
+		BacktestResult& result = summary.results[task];
+		result = RunTask(data.Get(symbol), config.sweep[paramIndex], config);
+		result.symbol = symbol;
+		result.paramIndex = paramIndex;
+	});
+
+	summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	summary.perParams.resize(config.sweep.size());
+	for (size_t p = 0; p < config.sweep.size(); ++p)
+	{
+		summary.perParams[p].params = config.sweep[p];
+	}
+	for (const BacktestResult& result : summary.results)
+	{
+		BacktestParamSummary& total = summary.perParams[result.paramIndex];
+		total.totalPnl += result.pnl;
+		total.worstDrawdown = std::max(total.worstDrawdown, result.maxDrawdown);
+		total.profitableSymbols += result.pnl > 0.0 ? 1 : 0;
+		total.orders += result.orders;
+		total.trades += result.trades;
+		total.requestedQuantity += result.requestedQuantity;
+		total.filledQuantity += result.filledQuantity;
+	}
+
+	return summary;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "MarketData.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// What a strategy sees before a bar trades: rows before index are history,
+// only the open of row index is known.
+struct BarContext
+{
+	const DataStore& bars;
+	size_t index;
+	int64_t position;
+};
+
+class Strategy
+{
+public:
+	virtual ~Strategy() = default;
+
+	// called once per symbol before the first bar, e.g. to precompute indicators
+	virtual void Begin(const DataStore&) {}
+	// position the strategy wants to hold through this bar, the engine trades the difference
+	virtual int64_t TargetPosition(const BarContext& context) = 0;
+};
+
+struct StrategyParams
+{
+	uint32_t fastPeriod{ 10 };
+	uint32_t slowPeriod{ 50 };
+	int64_t size{ 100 };
+};
+
+using StrategyFactory = std::function<std::unique_ptr<Strategy>(const StrategyParams&)>;
+
+// long size while the fast SMA of closes is above the slow one, short size below
+class MovingAverageCross : public Strategy
+{
+public:
+	explicit MovingAverageCross(const StrategyParams& _params) : params{ _params } {}
+
+	void Begin(const DataStore& bars) override;
+	int64_t TargetPosition(const BarContext& context) override;
+
+private:
+	StrategyParams params;
+	std::vector<double> fast;
+	std::vector<double> slow;
+};
+
+// Resting orders the engine places around each bar's open, spread over the bar's range.
+struct LiquidityModel
+{
+	uint32_t levels{ 5 };         // per side
+	double participation{ 0.01 }; // share of the bar's volume offered on both sides together
+	double tickSize{ 0.01 };
+};
+
+struct BacktestConfig
+{
+	std::vector<StrategyParams> sweep{ StrategyParams{} };
+	StrategyFactory factory{ [](const StrategyParams& p) { return std::make_unique<MovingAverageCross>(p); } };
+	LiquidityModel liquidity;
+};
+
+struct BacktestResult
+{
+	SymbolID symbol{ INVALID_SYMBOL };
+	size_t paramIndex{};
+	double pnl{};
+	double maxDrawdown{};
+	uint64_t orders{};
+	uint64_t trades{};
+	uint64_t requestedQuantity{};
+	uint64_t filledQuantity{};
+};
+
+struct BacktestParamSummary
+{
+	StrategyParams params;
+	double totalPnl{};
+	double worstDrawdown{};
+	size_t profitableSymbols{};
+	uint64_t orders{};
+	uint64_t trades{};
+	uint64_t requestedQuantity{};
+	uint64_t filledQuantity{};
+};
+
+struct BacktestSummary
+{
+	std::vector<BacktestResult> results;       // one per symbol and parameter set
+	std::vector<BacktestParamSummary> perParams; // aggregated over symbols, in sweep order
+	size_t compressedSymbols{}; // left out, their history is compressed
+	double seconds{};
+	unsigned threads{};
+};
+
+// Replays every symbol against every parameter set in config.sweep.
+// Each task owns a single threaded OrderBook seeded with synthetic liquidity per bar, and the
+// strategy trades into it with FillAndKill orders, so fills pay for walking the book.
+// Tasks run on the work stealing pool; data must not change until this returns.
+// Symbols held compressed are not replayed, only counted in compressedSymbols.
+BacktestSummary RunBacktest(const MarketData& data, const BacktestConfig& config, unsigned numThreads = 0);
@@ -0,0 +1,499 @@
+#include "CompressedColumn.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// integral doubles up to here convert to int64 and back exactly
+	constexpr double MAX_EXACT_INTEGER = 9007199254740992.0;
+	constexpr double POWERS_OF_TEN[] = { 1.0, 10.0, 100.0, 1000.0, 10000.0 };
+
+	// bits are filled from the most significant end of each word
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::pmr::vector<uint64_t>& _words) : words{ _words } {}
+
+		// low bits of value, 1 to 64 of them
+		void Write(uint64_t value, unsigned bits)
+		{
+			if (bits < 64)
+				value &= (uint64_t(1) << bits) - 1;
+			if (used == 64)
+			{
+				words.push_back(0);
+				used = 0;
+			}
+
+			const unsigned room = 64 - used;
+			if (bits <= room)
+			{
+				words.back() |= value << (room - bits);
+				used += bits;
+			}
+			else
+			{
+				const unsigned spill = bits - room;
+				words.back() |= value >> spill;
+				words.push_back(value << (64 - spill));
+				used = spill;
+			}
+		}
+
+	private:
+		std::pmr::vector<uint64_t>& words;
+		unsigned used{ 64 }; // the first write starts a new word, so blocks are word aligned
+	};
+
+	class BitReader
+	{
+	public:
+		explicit BitReader(const uint64_t* _words) : words{ _words } {}
+
+		uint64_t Read(unsigned bits)
+		{
+			const uint64_t* word = words + (position >> 6);
+			const unsigned offset = (unsigned)(position & 63);
+			uint64_t value = word[0] << offset;
+			if (offset + bits > 64)
+				value |= word[1] >> (64 - offset);
+			position += bits;
+			return value >> (64 - bits);
+		}
+
+		bool ReadBit() { return Read(1) != 0; }
+
+	private:
+		const uint64_t* words;
+		uint64_t position{};
+	};
+
+	int64_t SignExtend(uint64_t raw, unsigned bits)
+	{
+		return (int64_t)(raw << (64 - bits)) >> (64 - bits);
+	}
+
+	bool Integral(const double* values, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			// written so NaN fails too
+			if ((std::abs(values[i]) <= MAX_EXACT_INTEGER) == false || values[i] != std::trunc(values[i]))
+				return false;
+		}
+		return true;
+	}
+
+	// fewest decimals that reproduce every value exactly after scaling back, -1 if none do
+	int DecimalPlaces(const double* values, size_t count)
+	{
+		for (int decimals = 0; decimals < (int)std::size(POWERS_OF_TEN); ++decimals)
+		{
+			const double scale = POWERS_OF_TEN[decimals];
+			bool exact = true;
+			for (size_t i = 0; i < count && exact; ++i)
+			{
+				const double scaled = values[i] * scale;
+				exact = std::abs(scaled) <= MAX_EXACT_INTEGER && (double)std::llround(scaled) / scale == values[i];
+			}
+			if (exact)
+				return decimals;
+		}
+		return -1;
+	}
+
+	// daily bars only need the 32 bit bucket around weekends and holidays,
+	// small price deltas of Decimal blocks go through the same buckets
+	void WriteDeltaOfDelta(BitWriter& writer, int64_t dod)
+	{
+		if (dod == 0)
+			writer.Write(0, 1);
+		else if (dod >= -64 && dod < 64)
+		{
+			writer.Write(0b10, 2);
+			writer.Write((uint64_t)dod, 7);
+		}
+		else if (dod >= -256 && dod < 256)
+		{
+			writer.Write(0b110, 3);
+			writer.Write((uint64_t)dod, 9);
+		}
+		else if (dod >= -2048 && dod < 2048)
+		{
+			writer.Write(0b1110, 4);
+			writer.Write((uint64_t)dod, 12);
+		}
+		else if (dod >= INT32_MIN && dod <= INT32_MAX)
+		{
+			writer.Write(0b11110, 5);
+			writer.Write((uint64_t)dod, 32);
+		}
+		else
+		{
+			writer.Write(0b11111, 5);
+			writer.Write((uint64_t)dod, 64);
+		}
+	}
+
+	int64_t ReadDeltaOfDelta(BitReader& reader)
+	{
+		if (reader.ReadBit() == false)
+			return 0;
+		if (reader.ReadBit() == false)
+			return SignExtend(reader.Read(7), 7);
+		if (reader.ReadBit() == false)
+			return SignExtend(reader.Read(9), 9);
+		if (reader.ReadBit() == false)
+			return SignExtend(reader.Read(12), 12);
+		if (reader.ReadBit() == false)
+			return SignExtend(reader.Read(32), 32);
+		return (int64_t)reader.Read(64);
+	}
+
+	uint64_t ToBits(double value)
+	{
+		return std::bit_cast<uint64_t>(value);
+	}
+
+	double FromBits(uint64_t bits)
+	{
+		return std::bit_cast<double>(bits);
+	}
+}
+
+void CompressedColumn::Append(const double* values, size_t count)
+{
+	if (count == 0)
+		return;
+
+	double pending[BLOCK_ROWS];
+	size_t carried = 0;
+	if (blocks.empty() == false && blocks.back().rows < BLOCK_ROWS)
+	{
+		// the last block is at the end of the words, so it can simply be cut off
+		carried = DecodeBlock(blocks.size() - 1, pending);
+		words.resize(blocks.back().word);
+		blocks.pop_back();
+		rows -= carried;
+	}
+
+	while (count > 0)
+	{
+		const size_t take = std::min(BLOCK_ROWS - carried, count);
+		if (carried == 0)
+		{
+			EncodeBlock(values, take);
+		}
+		else
+		{
+			std::copy(values, values + take, pending + carried);
+			EncodeBlock(pending, carried + take);
+			carried = 0;
+		}
+		values += take;
+		count -= take;
+	}
+}
+
+size_t CompressedColumn::Bytes() const
+{
+	return words.size() * sizeof(uint64_t) + blocks.size() * sizeof(Block);
+}
+
+void CompressedColumn::EncodeBlock(const double* values, size_t count)
+{
+	Block block;
+	block.word = words.size();
+	block.rows = (uint32_t)count;
+	block.first = values[0];
+	for (size_t i = 0; i < count; ++i)
+	{
+		block.minimum = std::min(values[i], block.minimum);
+		block.maximum = std::max(values[i], block.maximum);
+	}
+	block.codec = codec != ColumnCodec::Float && Integral(values, count) ? codec : ColumnCodec::Float;
+	if (block.codec == ColumnCodec::Float)
+	{
+		const int decimals = DecimalPlaces(values, count);
+		if (decimals >= 0)
+		{
+			block.codec = ColumnCodec::Decimal;
+			block.decimals = (uint8_t)decimals;
+		}
+	}
+
+	BitWriter writer(words);
+	switch (block.codec)
+	{
+	case ColumnCodec::Timestamp:
+	{
+		int64_t previous = (int64_t)values[0];
+		int64_t delta = 0;
+		for (size_t i = 1; i < count; ++i)
+		{
+			const int64_t value = (int64_t)values[i];
+			WriteDeltaOfDelta(writer, (value - previous) - delta);
+			delta = value - previous;
+			previous = value;
+		}
+	}
+	break;
+	case ColumnCodec::Decimal:
+	{
+		const double scale = POWERS_OF_TEN[block.decimals];
+		int64_t previous = std::llround(values[0] * scale);
+		for (size_t i = 1; i < count; ++i)
+		{
+			const int64_t value = std::llround(values[i] * scale);
+			WriteDeltaOfDelta(writer, value - previous);
+			previous = value;
+		}
+	}
+	break;
+	case ColumnCodec::Integer:
+		for (size_t i = 1; i < count; ++i)
+		{
+			const int64_t value = (int64_t)values[i];
+			uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+			while (zigzag >= 0x80)
+			{
+				writer.Write((zigzag & 0x7f) | 0x80, 8);
+				zigzag >>= 7;
+			}
+			writer.Write(zigzag, 8);
+		}
+	break;
+	case ColumnCodec::Float:
+	{
+		// the previous value's meaningful bit window is reused while the XOR fits inside it
+		uint64_t previous = ToBits(values[0]);
+		unsigned leading = 0;
+		unsigned trailing = 0;
+		bool window = false;
+		for (size_t i = 1; i < count; ++i)
+		{
+			const uint64_t current = ToBits(values[i]);
+			const uint64_t x = current ^ previous;
+			previous = current;
+			if (x == 0)
+			{
+				writer.Write(0, 1);
+				continue;
+			}
+
+			const unsigned lead = std::min(31u, (unsigned)std::countl_zero(x));
+			const unsigned trail = (unsigned)std::countr_zero(x);
+			if (window && lead >= leading && trail >= trailing)
+			{
+				writer.Write(0b10, 2);
+				writer.Write(x >> trailing, 64 - leading - trailing);
+			}
+			else
+			{
+				const unsigned meaningful = 64 - lead - trail;
+				writer.Write(0b11, 2);
+				writer.Write(lead, 5);
+				writer.Write(meaningful - 1, 6);
+				writer.Write(x >> trail, meaningful);
+				leading = lead;
+				trailing = trail;
+				window = true;
+			}
+		}
+	}
+	break;
+	}
+
+	blocks.push_back(block);
+	rows += count;
+}
+
+size_t CompressedColumn::DecodeBlock(size_t index, double* out) const
+{
+	const Block& block = blocks[index];
+	BitReader reader(words.data() + block.word);
+	out[0] = block.first;
+
+	switch (block.codec)
+	{
+	case ColumnCodec::Timestamp:
+	{
+		int64_t previous = (int64_t)block.first;
+		int64_t delta = 0;
+		for (uint32_t i = 1; i < block.rows; ++i)
+		{
+			delta += ReadDeltaOfDelta(reader);
+			previous += delta;
+			out[i] = (double)previous;
+		}
+	}
+	break;
+	case ColumnCodec::Decimal:
+	{
+		const double scale = POWERS_OF_TEN[block.decimals];
+		int64_t previous = std::llround(block.first * scale);
+		for (uint32_t i = 1; i < block.rows; ++i)
+		{
+			previous += ReadDeltaOfDelta(reader);
+			out[i] = (double)previous / scale;
+		}
+	}
+	break;
+	case ColumnCodec::Integer:
+		for (uint32_t i = 1; i < block.rows; ++i)
+		{
+			uint64_t zigzag = 0;
+			for (unsigned shift = 0; ; shift += 7)
+			{
+				const uint64_t byte = reader.Read(8);
+				zigzag |= (byte & 0x7f) << shift;
+				if ((byte & 0x80) == 0)
+					break;
+			}
+			out[i] = (double)((int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1));
+		}
+	break;
+	case ColumnCodec::Float:
+	{
+		uint64_t previous = ToBits(block.first);
+		unsigned leading = 0;
+		unsigned trailing = 0;
+		for (uint32_t i = 1; i < block.rows; ++i)
+		{
+			if (reader.ReadBit())
+			{
+				if (reader.ReadBit())
+				{
+					leading = (unsigned)reader.Read(5);
+					const unsigned meaningful = (unsigned)reader.Read(6) + 1;
+					trailing = 64 - leading - meaningful;
+					previous ^= reader.Read(meaningful) << trailing;
+				}
+				else
+				{
+					previous ^= reader.Read(64 - leading - trailing) << trailing;
+				}
+			}
+			out[i] = FromBits(previous);
+		}
+	}
+	break;
+	}
+	return block.rows;
+}
+
+void CompressedColumn::Decode(size_t first, size_t last, double* out) const
+{
+	double scratch[BLOCK_ROWS];
+	for (size_t row = first; row < last; )
+	{
+		const size_t index = row / BLOCK_ROWS;
+		const size_t begin = index * BLOCK_ROWS;
+		const size_t blockEnd = begin + blocks[index].rows;
+		const size_t end = std::min(blockEnd, last);
+		if (row == begin && end == blockEnd)
+		{
+			DecodeBlock(index, out + (row - first));
+		}
+		else
+		{
+			DecodeBlock(index, scratch);
+			std::copy(scratch + (row - begin), scratch + (end - begin), out + (row - first));
+		}
+		row = end;
+	}
+}
+
+void CompressedColumn::Extent(size_t first, size_t last, double& outMin, double& outMax) const
+{
+	outMin = DBL_MAX;
+	outMax = -DBL_MAX;
+
+	double scratch[BLOCK_ROWS];
+	for (size_t row = first; row < last; )
+	{
+		const size_t index = row / BLOCK_ROWS;
+		const size_t begin = index * BLOCK_ROWS;
+		const size_t blockEnd = begin + blocks[index].rows;
+		const size_t end = std::min(blockEnd, last);
+		if (row == begin && end == blockEnd)
+		{
+			outMin = std::min(blocks[index].minimum, outMin);
+			outMax = std::max(blocks[index].maximum, outMax);
+		}
+		else
+		{
+			// only the blocks at either edge get here
+			DecodeBlock(index, scratch);
+			for (size_t i = row - begin; i < end - begin; ++i)
+			{
+				outMin = std::min(scratch[i], outMin);
+				outMax = std::max(scratch[i], outMax);
+			}
+		}
+		row = end;
+	}
+}
+
+size_t CompressedColumn::LowerBound(double value) const
+{
+	auto it = std::partition_point(blocks.begin(), blocks.end(), [value](const Block& block) { return block.maximum < value; });
+	if (it == blocks.end())
+		return rows;
+
+	const size_t index = it - blocks.begin();
+	double scratch[BLOCK_ROWS];
+	const size_t count = DecodeBlock(index, scratch);
+	return index * BLOCK_ROWS + (std::lower_bound(scratch, scratch + count, value) - scratch);
+}
+
+size_t CompressedColumn::UpperBound(double value) const
+{
+	auto it = std::partition_point(blocks.begin(), blocks.end(), [value](const Block& block) { return block.maximum <= value; });
+	if (it == blocks.end())
+		return rows;
+
+	const size_t index = it - blocks.begin();
+	double scratch[BLOCK_ROWS];
+	const size_t count = DecodeBlock(index, scratch);
+	return index * BLOCK_ROWS + (std::upper_bound(scratch, scratch + count, value) - scratch);
+}
+
+CompressedStore::CompressedStore(const DataStore& source)
+{
+	const size_t count = source.size();
+	date.Append(source.date.data(), count);
+	open.Append(source.open.data(), count);
+	close.Append(source.close.data(), count);
+	high.Append(source.high.data(), count);
+	low.Append(source.low.data(), count);
+	volume.Append(source.volume.data(), count);
+}
+
+size_t CompressedStore::Bytes() const
+{
+	return date.Bytes() + open.Bytes() + close.Bytes() + high.Bytes() + low.Bytes() + volume.Bytes();
+}
+
+void CompressedStore::Decode(size_t first, size_t last, DataStore& out) const
+{
+	last = std::min(last, size());
+	first = std::min(first, last);
+	const size_t count = last - first;
+	date.Decode(first, last, out.date.Overwrite(count));
+	open.Decode(first, last, out.open.Overwrite(count));
+	close.Decode(first, last, out.close.Overwrite(count));
+	high.Decode(first, last, out.high.Overwrite(count));
+	low.Decode(first, last, out.low.Overwrite(count));
+	volume.Decode(first, last, out.volume.Overwrite(count));
+	out.BuildExtents();
+}
+
+void CompressedStore::RangeExtent(size_t first, size_t last, double& outMin, double& outMax) const
+{
+	double unused;
+	low.Extent(first, last, outMin, unused);
+	high.Extent(first, last, unused, outMax);
+}
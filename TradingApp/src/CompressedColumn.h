@@ -0,0 +1,98 @@
+#pragma once
+#include "DataStore.h"
+#include "Memory.h"
+#include <cfloat>
+#include <cstdint>
+#include <memory_resource>
+
+enum class ColumnCodec : uint8_t
+{
+	Timestamp, // delta of delta, for evenly spaced integral times
+	Float,     // XOR with the previous value, for slowly moving prices
+	Integer,   // zigzag varint, for counts such as volume
+	Decimal    // deltas of values scaled by a power of ten, picked per block for Float columns
+};
+
+// Doubles packed into independently decodable blocks of BLOCK_ROWS values.
+// Every block keeps its first value and its min/max uncompressed, so range
+// extents and searches on ascending columns only decode the blocks at the edges.
+// A block that does not suit the column's codec (fractional times or volumes)
+// falls back to Float. Float blocks whose values all have few decimals, as quoted
+// prices do, are stored as Decimal instead: XOR on such values leaves most of the
+// mantissa bits set.
+class CompressedColumn
+{
+public:
+	static constexpr size_t BLOCK_ROWS = 256;
+
+	struct Block
+	{
+		size_t word{};   // first 64-bit word of the block's bits
+		uint32_t rows{};
+		ColumnCodec codec{};
+		uint8_t decimals{}; // scale of a Decimal block
+		double first{};
+		double minimum{ DBL_MAX };
+		double maximum{ -DBL_MAX };
+	};
+
+	explicit CompressedColumn(ColumnCodec _codec = ColumnCodec::Float) : codec{ _codec } {}
+
+	// re-encodes a partial last block together with the new values
+	void Append(const double* values, size_t count);
+
+	size_t size() const { return rows; }
+	bool empty() const { return rows == 0; }
+	// packed bits and block headers
+	size_t Bytes() const;
+
+	size_t Blocks() const { return blocks.size(); }
+	const Block& GetBlock(size_t block) const { return blocks[block]; }
+
+	// fast path, writes the block's rows to out and returns how many there were
+	size_t DecodeBlock(size_t block, double* out) const;
+	// rows [first, last) to out
+	void Decode(size_t first, size_t last, double* out) const;
+
+	// smallest and largest value over rows [first, last)
+	void Extent(size_t first, size_t last, double& outMin, double& outMax) const;
+
+	// binary searches for ascending columns such as dates
+	size_t LowerBound(double value) const;
+	size_t UpperBound(double value) const;
+
+private:
+	void EncodeBlock(const double* values, size_t count);
+
+	ColumnCodec codec;
+	size_t rows{};
+	std::pmr::vector<uint64_t> words{ Memory::Tracked(MemoryTag::MarketData) };
+	std::pmr::vector<Block> blocks{ Memory::Tracked(MemoryTag::MarketData) };
+};
+
+// All six columns of a DataStore in compressed form.
+class CompressedStore
+{
+public:
+	explicit CompressedStore(const DataStore& source);
+
+	CompressedStore(const CompressedStore&) = delete;
+	CompressedStore& operator=(const CompressedStore&) = delete;
+
+	size_t size() const { return date.size(); }
+	size_t Bytes() const;
+
+	// rows [first, last) into out's columns, which then own them;
+	// name and overall extremes are left alone
+	void Decode(size_t first, size_t last, DataStore& out) const;
+
+	// lowest low and highest high over rows [first, last)
+	void RangeExtent(size_t first, size_t last, double& outMin, double& outMax) const;
+
+	CompressedColumn date{ ColumnCodec::Timestamp };
+	CompressedColumn open{ ColumnCodec::Float };
+	CompressedColumn close{ ColumnCodec::Float };
+	CompressedColumn high{ ColumnCodec::Float };
+	CompressedColumn low{ ColumnCodec::Float };
+	CompressedColumn volume{ ColumnCodec::Integer };
+};
@@ -0,0 +1,245 @@
+#include "Correlation.h"
+#include "Cpu.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#define CORRELATION_AVX2 CPU_X64
+
+namespace
+{
+	// register tile of the kernel: TILE_ROWS symbols against TILE_COLS symbols
+	constexpr size_t TILE_ROWS = 4;
+	constexpr size_t TILE_COLS = 8;
+	// days per pass so the tile's slice of the return matrix stays in cache
+	constexpr size_t DAY_BLOCK = 256;
+
+	// returns are packed in panels of TILE_COLS symbols, each panel holding every day,
+	// so a tile walks two contiguous streams instead of striding across all symbols
+	inline const double* Panel(const double* r, size_t days, size_t symbol)
+	{
+		return r + symbol / TILE_COLS * days * TILE_COLS;
+	}
+
+#if CORRELATION_AVX2
+	AVX2_TARGET void KernelTileAvx2(const double* rowPanel, const double* colPanel, size_t stride, size_t first, size_t last, size_t row, size_t col, double sign, double* sums)
+	{
+		__m256d acc[TILE_ROWS][2];
+		for (auto& pair : acc)
+		{
+			pair[0] = _mm256_setzero_pd();
+			pair[1] = _mm256_setzero_pd();
+		}
+
+		for (size_t day = first; day < last; ++day)
+		{
+			const double* a = rowPanel + day * TILE_COLS;
+			const double* b = colPanel + day * TILE_COLS;
+			const __m256d b0 = _mm256_loadu_pd(b);
+			const __m256d b1 = _mm256_loadu_pd(b + 4);
+			for (size_t m = 0; m < TILE_ROWS; ++m)
+			{
+				const __m256d am = _mm256_broadcast_sd(a + m);
+				acc[m][0] = _mm256_fmadd_pd(am, b0, acc[m][0]);
+				acc[m][1] = _mm256_fmadd_pd(am, b1, acc[m][1]);
+			}
+		}
+
+		const __m256d scale = _mm256_set1_pd(sign);
+		for (size_t m = 0; m < TILE_ROWS; ++m)
+		{
+			double* out = sums + (row + m) * stride + col;
+			_mm256_storeu_pd(out, _mm256_fmadd_pd(acc[m][0], scale, _mm256_loadu_pd(out)));
+			_mm256_storeu_pd(out + 4, _mm256_fmadd_pd(acc[m][1], scale, _mm256_loadu_pd(out + 4)));
+		}
+	}
+#endif
+
+	// sums[i][j] += sign * sum over days [first, last) of r[day][i] * r[day][j]
+	// for the TILE_ROWS x TILE_COLS tile at (row, col)
+	void KernelTile(const double* r, size_t days, size_t stride, size_t first, size_t last, size_t row, size_t col, double sign, double* sums)
+	{
+		const double* rowPanel = Panel(r, days, row) + row % TILE_COLS;
+		const double* colPanel = Panel(r, days, col);
+
+#if CORRELATION_AVX2
+		if (Cpu::HasAvx2())
+		{
+			KernelTileAvx2(rowPanel, colPanel, stride, first, last, row, col, sign, sums);
+			return;
+		}
+#endif
+		double acc[TILE_ROWS][TILE_COLS]{};
+		for (size_t day = first; day < last; ++day)
+		{
+			const double* a = rowPanel + day * TILE_COLS;
+			const double* b = colPanel + day * TILE_COLS;
+			for (size_t m = 0; m < TILE_ROWS; ++m)
+			{
+				for (size_t n = 0; n < TILE_COLS; ++n)
+					acc[m][n] += a[m] * b[n];
+			}
+		}
+
+		for (size_t m = 0; m < TILE_ROWS; ++m)
+		{
+			double* out = sums + (row + m) * stride + col;
+			for (size_t n = 0; n < TILE_COLS; ++n)
+				out[n] += sign * acc[m][n];
+		}
+	}
+}
+
+void CorrelationMatrix::Build(const MarketData& data)
+{
+	PROFILE_SCOPE("Correlation::Build");
+	symbols = data.Count();
+	stride = (symbols + TILE_COLS - 1) / TILE_COLS * TILE_COLS;
+
+	// joined axis is the union of every symbol's dates
+	dates.clear();
+	for (const DataStore& ds : data.Stores())
+		dates.insert(dates.end(), ds.date.begin(), ds.date.end());
+	std::sort(dates.begin(), dates.end());
+	dates.erase(std::unique(dates.begin(), dates.end()), dates.end());
+
+	returns.assign(dates.size() * stride, 0.0);
+	compressed = 0;
+	for (size_t s = 0; s < symbols; ++s)
+	{
+		const DataStore& ds = data.Get((SymbolID)s);
+		if (ds.IsCompressed())
+		{
+			++compressed;
+			continue;
+		}
+		const double* day = dates.data();
+		const double* lastDay = dates.data() + dates.size();
+		for (size_t i = 1; i < ds.size(); ++i)
+		{
+			day = std::lower_bound(day, lastDay, ds.date[i]);
+			const double prev = ds.close[i - 1];
+			const double curr = ds.close[i];
+			if (prev > 0.0 && curr > 0.0)
+				returns[(s / TILE_COLS * dates.size() + (day - dates.data())) * TILE_COLS + s % TILE_COLS] = std::log(curr / prev);
+		}
+	}
+
+	sumXY.assign(stride * stride, 0.0);
+	sumX.assign(stride, 0.0);
+	windowFirst = windowLast = 0;
+	covariance.assign(symbols * symbols, 0.0);
+	correlation.assign(symbols * symbols, 0.0);
+}
+
+void CorrelationMatrix::SetWindow(size_t first, size_t last, unsigned numThreads)
+{
+	PROFILE_SCOPE("Correlation::SetWindow");
+	last = std::min(last, dates.size());
+	first = std::min(first, last);
+
+	if (first >= windowLast || last <= windowFirst)
+	{
+		// nothing shared with the old window, start from zero
+		std::fill(sumXY.begin(), sumXY.end(), 0.0);
+		std::fill(sumX.begin(), sumX.end(), 0.0);
+		Accumulate(first, last, 1.0, numThreads);
+	}
+	else
+	{
+		if (first > windowFirst)
+			Accumulate(windowFirst, first, -1.0, numThreads);
+		else if (first < windowFirst)
+			Accumulate(first, windowFirst, 1.0, numThreads);
+
+		if (last > windowLast)
+			Accumulate(windowLast, last, 1.0, numThreads);
+		else if (last < windowLast)
+			Accumulate(last, windowLast, -1.0, numThreads);
+	}
+
+	windowFirst = first;
+	windowLast = last;
+	Finish();
+}
+
+void CorrelationMatrix::Accumulate(size_t first, size_t last, double sign, unsigned numThreads)
+{
+	if (first >= last || symbols == 0)
+		return;
+
+	for (size_t s = 0; s < stride; ++s)
+	{
+		const double* values = Panel(returns.data(), dates.size(), s) + s % TILE_COLS;
+		double sum = 0.0;
+		for (size_t day = first; day < last; ++day)
+			sum += values[day * TILE_COLS];
+		sumX[s] += sign * sum;
+	}
+
+	if (numThreads == 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	// row tiles are dealt out round robin so the triangle's uneven rows even out
+	const size_t rowTiles = stride / TILE_ROWS;
+	numThreads = (unsigned)std::min<size_t>(numThreads, rowTiles);
+
+	std::vector<std::jthread> workers;
+	workers.reserve(numThreads);
+	for (unsigned t = 0; t < numThreads; ++t)
+	{
+		workers.emplace_back([this, first, last, sign, numThreads, rowTiles, t] {
+			PROFILE_THREAD("Correlation worker");
+			PROFILE_SCOPE("Correlation::Accumulate");
+			for (size_t dayBlock = first; dayBlock < last; dayBlock += DAY_BLOCK)
+			{
+				const size_t dayEnd = std::min(dayBlock + DAY_BLOCK, last);
+				for (size_t tile = t; tile < rowTiles; tile += numThreads)
+				{
+					const size_t row = tile * TILE_ROWS;
+					// only the upper triangle, starting at the column tile holding the diagonal
+					for (size_t col = row / TILE_COLS * TILE_COLS; col < stride; col += TILE_COLS)
+						KernelTile(returns.data(), dates.size(), stride, dayBlock, dayEnd, row, col, sign, sumXY.data());
+				}
+			}
+		});
+	}
+}
+
+void CorrelationMatrix::Finish()
+{
+	const double n = (double)(windowLast - windowFirst);
+	if (n < 2.0)
+	{
+		std::fill(covariance.begin(), covariance.end(), 0.0);
+		std::fill(correlation.begin(), correlation.end(), 0.0);
+		return;
+	}
+
+	for (size_t i = 0; i < symbols; ++i)
+	{
+		for (size_t j = i; j < symbols; ++j)
+		{
+			const double value = (sumXY[i * stride + j] - sumX[i] * sumX[j] / n) / (n - 1.0);
+			covariance[i * symbols + j] = value;
+			covariance[j * symbols + i] = value;
+		}
+	}
+
+	for (size_t i = 0; i < symbols; ++i)
+	{
+		const double varI = covariance[i * symbols + i];
+		for (size_t j = i; j < symbols; ++j)
+		{
+			const double varJ = covariance[j * symbols + j];
+			double value = 0.0;
+			if (varI > 0.0 && varJ > 0.0)
+				value = std::clamp(covariance[i * symbols + j] / std::sqrt(varI * varJ), -1.0, 1.0);
+			else if (i == j)
+				value = 1.0;
+			correlation[i * symbols + j] = value;
+			correlation[j * symbols + i] = value;
+		}
+	}
+}
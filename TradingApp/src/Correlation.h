@@ -0,0 +1,49 @@
+#pragma once
+#include "MarketData.h"
+#include <cstdint>
+#include <vector>
+
+// Covariance and correlation of daily log returns across every symbol.
+// Returns are joined onto one date axis (a symbol without a row on a date counts as flat)
+// and the pairwise sums are built with a blocked, multi-threaded rank-k update.
+// Moving the window only adds the days that enter it and removes the days that leave.
+class CorrelationMatrix
+{
+public:
+	// rebuilds the joined return matrix, needed again after the market changes;
+	// compressed symbols are left out, their rows and columns stay zero
+	void Build(const MarketData& data);
+
+	// moves the window to joined days [first, last)
+	void SetWindow(size_t first, size_t last, unsigned numThreads = 0);
+
+	size_t Symbols() const { return symbols; }
+	// symbols whose history was compressed when the matrix was built
+	size_t CompressedSymbols() const { return compressed; }
+	size_t Days() const { return dates.size(); }
+	const std::vector<double>& Dates() const { return dates; }
+	size_t WindowFirst() const { return windowFirst; }
+	size_t WindowLast() const { return windowLast; }
+
+	// symbols x symbols, row-major
+	const std::vector<double>& Covariance() const { return covariance; }
+	const std::vector<double>& Correlation() const { return correlation; }
+
+private:
+	void Accumulate(size_t first, size_t last, double sign, unsigned numThreads);
+	void Finish();
+
+	size_t symbols{};
+	size_t compressed{};
+	size_t stride{}; // symbols padded to the kernel tile width
+	std::vector<double> dates;
+	std::vector<double> returns; // panels of 8 symbols x days, see Correlation.cpp
+
+	std::vector<double> sumXY; // stride x stride, upper triangle is valid
+	std::vector<double> sumX;
+	size_t windowFirst{};
+	size_t windowLast{};
+
+	std::vector<double> covariance;
+	std::vector<double> correlation;
+};
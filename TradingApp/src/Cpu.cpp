@@ -0,0 +1,40 @@
+#include "Cpu.h"
+#include <cstdlib>
+
+#if CPU_X64 && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	bool DetectAvx2()
+	{
+		if (std::getenv("TRADING_NO_AVX2") != nullptr)
+			return false;
+#if CPU_X64 && defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (fma == false || osxsave == false || (_xgetbv(0) & 0x6) != 0x6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif CPU_X64
+		// checks the OS side through xgetbv as well
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+		return false;
+#endif
+	}
+}
+
+bool Cpu::HasAvx2()
+{
+	static const bool hasAvx2 = DetectAvx2();
+	return hasAvx2;
+}
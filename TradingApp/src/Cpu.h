@@ -0,0 +1,24 @@
+#pragma once
+
+// Vector kernels are compiled for AVX2 and FMA one function at a time and chosen at run
+// time, so the rest of the program, and the binary as a whole, still runs on x86-64 CPUs
+// without them. MSVC accepts the intrinsics without /arch, GCC and Clang need the attribute.
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define CPU_X64 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+#else
+#define CPU_X64 0
+#define AVX2_TARGET
+#endif
+
+namespace Cpu
+{
+	// AVX2 and FMA are both there and the OS saves the ymm registers.
+	// TRADING_NO_AVX2 set in the environment forces the scalar paths, to test them on any machine.
+	bool HasAvx2();
+}
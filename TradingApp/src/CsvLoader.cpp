@@ -0,0 +1,335 @@
+#include "CsvLoader.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+	constexpr size_t CSV_FIELDS = 7;
+	constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+
+	const char* NextLine(const char* cursor, const char* end)
+	{
+		const char* eol = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+		return eol ? eol + 1 : end;
+	}
+
+	double ToDouble(std::string_view field)
+	{
+		double value = 0;
+		if (field.empty() == false)
+		{
+			std::from_chars(field.data(), field.data() + field.size(), value);
+		}
+		return value;
+	}
+
+	double ToDate(std::string_view field)
+	{
+		uint64_t value = 0;
+		if (field.empty() == false)
+		{
+			std::from_chars(field.data(), field.data() + field.size(), value);
+		}
+		return (double)(value / 1000);
+	}
+
+	// run of consecutive rows of one symbol inside a chunk
+	struct Segment
+	{
+		std::string_view name;
+		const char* begin{};
+		const char* end{};
+		size_t rows{};
+		SymbolID id{ INVALID_SYMBOL };
+		size_t firstRow{};
+		double minimum{ DBL_MAX };
+		double maximum{ -DBL_MAX };
+	};
+
+	// counting pass, finds the name of every valid row without converting any numbers
+	void CountChunk(const char* begin, const char* end, std::vector<Segment>& outSegments)
+	{
+		const char* cursor = begin;
+		while (cursor < end)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+			if (lineEnd == nullptr)
+				lineEnd = end;
+			const char* next = lineEnd == end ? end : lineEnd + 1;
+
+			// same rule as ParseCsvRow, the name is everything after the sixth comma
+			size_t commas = 0;
+			const char* p = cursor;
+			while (p < lineEnd && commas < CSV_FIELDS - 1)
+			{
+				if (*p++ == ',')
+					++commas;
+			}
+
+			if (commas == CSV_FIELDS - 1)
+			{
+				std::string_view name(p, lineEnd - p);
+				if (name.empty() == false && name.back() == '\r')
+					name.remove_suffix(1);
+
+				if (outSegments.empty() || outSegments.back().name != name)
+				{
+					outSegments.push_back(Segment{ name, cursor, next });
+				}
+				outSegments.back().end = next;
+				outSegments.back().rows++;
+			}
+			cursor = next;
+		}
+	}
+
+	// fill pass, converts rows straight into the symbol's arena slices
+	void FillSegment(MarketData& data, Segment& segment)
+	{
+		double* columns[MarketData::NUM_COLUMNS];
+		data.ArenaColumns(segment.id, columns);
+
+		size_t row = segment.firstRow;
+		const char* cursor = segment.begin;
+		while (cursor < segment.end)
+		{
+			DataFrame df{};
+			std::string_view name;
+			if (ParseCsvRow(cursor, segment.end, df, name) == false)
+				continue;
+
+			columns[0][row] = df.date;
+			columns[1][row] = df.open;
+			columns[2][row] = df.high;
+			columns[3][row] = df.low;
+			columns[4][row] = df.close;
+			columns[5][row] = df.volume;
+			++row;
+
+			segment.maximum = std::max(df.high, segment.maximum);
+			segment.minimum = std::min(df.low, segment.minimum);
+		}
+	}
+
+	template <typename Fn>
+	void RunWorkers(unsigned numThreads, Fn&& fn)
+	{
+		std::vector<std::jthread> workers;
+		workers.reserve(numThreads);
+		for (unsigned i = 0; i < numThreads; ++i)
+		{
+			workers.emplace_back([&fn, i] {
+				PROFILE_THREAD("Load worker");
+				fn(i);
+			});
+		}
+	}
+}
+
+bool ParseCsvRow(const char*& cursor, const char* end, DataFrame& outFrame, std::string_view& outName)
+{
+	const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+	if (lineEnd == nullptr)
+		lineEnd = end;
+
+	std::string_view fields[CSV_FIELDS];
+	size_t numFields = 0;
+	const char* fieldBegin = cursor;
+	for (const char* p = cursor; p < lineEnd && numFields < CSV_FIELDS - 1; ++p)
+	{
+		if (*p == ',')
+		{
+			fields[numFields++] = std::string_view(fieldBegin, p - fieldBegin);
+			fieldBegin = p + 1;
+		}
+	}
+	fields[numFields++] = std::string_view(fieldBegin, lineEnd - fieldBegin);
+
+	cursor = lineEnd == end ? end : lineEnd + 1;
+
+	if (numFields != CSV_FIELDS)
+		return false;
+
+	std::string_view name = fields[6];
+	if (name.empty() == false && name.back() == '\r')
+		name.remove_suffix(1);
+
+	outFrame.date = ToDate(fields[0]);
+	outFrame.open = ToDouble(fields[1]);
+	outFrame.high = ToDouble(fields[2]);
+	outFrame.low = ToDouble(fields[3]);
+	outFrame.close = ToDouble(fields[4]);
+	outFrame.volume = ToDouble(fields[5]);
+	outName = name;
+	return true;
+}
+
+void LoadProgress::Reset(size_t symbols, bool allReady)
+{
+	total = symbols;
+	ready = std::make_unique<std::atomic<bool>[]>(symbols);
+	for (size_t i = 0; i < symbols; ++i)
+		ready[i].store(allReady, std::memory_order_relaxed);
+	loaded.store(allReady ? symbols : 0, std::memory_order_release);
+}
+
+void LoadProgress::MarkReady(SymbolID id)
+{
+	ready[id].store(true, std::memory_order_release);
+	loaded.fetch_add(1, std::memory_order_acq_rel);
+}
+
+bool LoadCsv(const char* fileName, MarketData& outData, unsigned numThreads, LoadProgress* progress, bool wholeLines)
+{
+	PROFILE_SCOPE("LoadCsv");
+	MappedFile file;
+	if (file.Open(fileName, true) == false)
+		return false;
+
+	const char* end = file.Data() + file.Size();
+	if (wholeLines)
+	{
+		while (end > file.Data() && end[-1] != '\n')
+			--end;
+	}
+	const char* begin = NextLine(file.Data(), end); // discard header
+
+	if (numThreads == 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	const size_t bytes = end - begin;
+	numThreads = (unsigned)std::clamp<size_t>(bytes / MIN_CHUNK_BYTES, 1, numThreads);
+
+	// chunk boundaries always sit just past a newline
+	std::vector<const char*> bounds(numThreads + 1);
+	bounds.front() = begin;
+	bounds.back() = end;
+	for (unsigned i = 1; i < numThreads; ++i)
+	{
+		const char* guess = begin + bytes * i / numThreads;
+		bounds[i] = std::max(bounds[i - 1], NextLine(guess, end));
+	}
+
+	std::vector<std::vector<Segment>> chunks(numThreads);
+	RunWorkers(numThreads, [&](unsigned i) {
+		PROFILE_SCOPE("LoadCsv::Count");
+		CountChunk(bounds[i], bounds[i + 1], chunks[i]);
+	});
+
+	// intern symbols in name order and size the arena from the counts
+	std::unordered_map<std::string_view, size_t> rowsPerName;
+	for (const auto& segments : chunks)
+	{
+		for (const Segment& segment : segments)
+		{
+			rowsPerName[segment.name] += segment.rows;
+		}
+	}
+
+	std::vector<std::string> symbolNames;
+	symbolNames.reserve(rowsPerName.size());
+	for (const auto& [name, rows] : rowsPerName)
+	{
+		symbolNames.emplace_back(name);
+	}
+	std::sort(symbolNames.begin(), symbolNames.end());
+
+	std::vector<size_t> rowCounts(symbolNames.size());
+	for (size_t i = 0; i < symbolNames.size(); ++i)
+	{
+		rowCounts[i] = rowsPerName[symbolNames[i]];
+	}
+	outData.Allocate(std::move(symbolNames), rowCounts);
+
+	if (progress)
+	{
+		progress->Reset(outData.Count());
+		progress->SetSourceBytes(end - file.Data());
+		progress->Publish();
+	}
+
+	// segments in file order give each one its first row within the symbol
+	std::vector<size_t> nextRow(outData.Count());
+	std::vector<std::vector<Segment*>> symbolSegments(outData.Count());
+	for (auto& segments : chunks)
+	{
+		for (Segment& segment : segments)
+		{
+			segment.id = outData.Find(segment.name);
+			segment.firstRow = nextRow[segment.id];
+			nextRow[segment.id] += segment.rows;
+			symbolSegments[segment.id].push_back(&segment);
+		}
+	}
+
+	// workers claim whole symbols in name order, a prioritized symbol jumps the queue
+	std::vector<std::atomic<bool>> claimed(outData.Count());
+	std::atomic<size_t> nextSymbol{};
+	auto claimNext = [&]() -> SymbolID {
+		if (progress)
+		{
+			const SymbolID wanted = progress->TakePriority();
+			if (wanted < claimed.size() && claimed[wanted].exchange(true) == false)
+				return wanted;
+		}
+		for (size_t id = nextSymbol++; id < claimed.size(); id = nextSymbol++)
+		{
+			if (claimed[id].exchange(true) == false)
+				return (SymbolID)id;
+		}
+		return INVALID_SYMBOL;
+	};
+
+	RunWorkers(numThreads, [&](unsigned) {
+		for (SymbolID id = claimNext(); id != INVALID_SYMBOL; id = claimNext())
+		{
+			PROFILE_SCOPE("LoadCsv::Fill");
+			DataStore& ds = outData.Get(id);
+			for (Segment* segment : symbolSegments[id])
+			{
+				FillSegment(outData, *segment);
+				ds.maximum = std::max(segment->maximum, ds.maximum);
+				ds.minimum = std::min(segment->minimum, ds.minimum);
+			}
+			ds.BuildExtents();
+
+			if (progress)
+				progress->MarkReady(id);
+		}
+	});
+
+	return true;
+}
+
+uint64_t WholeLineBytes(const char* fileName)
+{
+	std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+	if (file.is_open() == false)
+		return 0;
+
+	// backwards a block at a time, the last line is usually short
+	constexpr uint64_t BLOCK = 4096;
+	char block[BLOCK];
+	uint64_t end = (uint64_t)file.tellg();
+	while (end > 0)
+	{
+		const uint64_t begin = end > BLOCK ? end - BLOCK : 0;
+		file.seekg((std::streamoff)begin);
+		if (file.read(block, (std::streamsize)(end - begin)).fail())
+			return 0;
+		for (uint64_t i = end - begin; i > 0; --i)
+		{
+			if (block[i - 1] == '\n')
+				return begin + i;
+		}
+		end = begin;
+	}
+	return 0;
+}
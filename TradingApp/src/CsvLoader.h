@@ -0,0 +1,61 @@
+#pragma once
+#include "DataStore.h"
+#include "MarketData.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+// Parses one "date,open,high,low,close,volume,name" row starting at cursor and advances
+// cursor past the line ending. outName views into the input, nothing is allocated.
+bool ParseCsvRow(const char*& cursor, const char* end, DataFrame& outFrame, std::string_view& outName);
+
+// Lets another thread follow a load running in the background.
+// Nothing in the MarketData may be touched before Indexed(), and a symbol's store
+// only once Ready() reports it finished. Symbols added after the load are always ready.
+// Every symbol can be ready while the loader still reads the market, to write the cache,
+// so anything that changes the MarketData waits for Done().
+class LoadProgress
+{
+public:
+	// called by the loader once the symbol count is known, before Publish
+	void Reset(size_t symbols, bool ready = false);
+	// names and stores are allocated and may be read from now on
+	void Publish() { indexed.store(true, std::memory_order_release); }
+	void MarkReady(SymbolID id);
+	// the loader is through with the MarketData, called once after the last MarkReady
+	void Finish() { finished.store(true, std::memory_order_release); }
+	// bytes of the source that the load covered, appended data starts here
+	void SetSourceBytes(uint64_t bytes) { sourceBytes.store(bytes, std::memory_order_relaxed); }
+
+	bool Indexed() const { return indexed.load(std::memory_order_acquire); }
+	bool Ready(SymbolID id) const { return Indexed() && (id >= total || ready[id].load(std::memory_order_acquire)); }
+	bool Done() const { return finished.load(std::memory_order_acquire); }
+	size_t Loaded() const { return loaded.load(std::memory_order_relaxed); }
+	size_t Total() const { return total; }
+	uint64_t SourceBytes() const { return sourceBytes.load(std::memory_order_relaxed); }
+
+	// asks the loader to fill this symbol next
+	void Prioritize(SymbolID id) { priority.store(id, std::memory_order_relaxed); }
+	SymbolID TakePriority() { return priority.exchange(INVALID_SYMBOL, std::memory_order_relaxed); }
+
+private:
+	std::atomic<bool> indexed{ false };
+	std::atomic<bool> finished{ false };
+	std::atomic<size_t> loaded{};
+	std::atomic<SymbolID> priority{ INVALID_SYMBOL };
+	std::atomic<uint64_t> sourceBytes{};
+	size_t total{};
+	std::unique_ptr<std::atomic<bool>[]> ready;
+};
+
+// Memory maps fileName, splits it into newline aligned chunks and loads them in two passes on
+// numThreads workers (0 uses every hardware thread). The first pass only counts rows per symbol
+// so the second can convert every row straight into its final slot in the MarketData arena.
+// The second pass fills one symbol at a time and reports each to progress when given.
+// wholeLines stops at the last newline, for files another process is still appending to;
+// the line being written is then left for a follower starting at progress's SourceBytes.
+bool LoadCsv(const char* fileName, MarketData& outData, unsigned numThreads = 0, LoadProgress* progress = nullptr, bool wholeLines = false);
+
+// bytes of fileName up to and including its last newline, 0 when it has none or cannot be read
+uint64_t WholeLineBytes(const char* fileName);
@@ -0,0 +1,256 @@
+#include "DataStore.h"
+#include "CompressedColumn.h"
+#include <algorithm>
+#include <cstdio>
+
+void DataFrame::Print()
+{
+    printf("%zd- %lf,%lf,%lf,%lf,%lf \n", (size_t)date, open,
+        close,
+        high,
+        low,
+        volume);
+}
+
+void Column::push_back(double value)
+{
+    Detach();
+    storage.push_back(value);
+}
+
+void Column::set(size_t i, double value)
+{
+    Detach();
+    storage[i] = value;
+}
+
+void Column::append(const Column& other)
+{
+    Detach();
+    storage.insert(storage.end(), other.begin(), other.end());
+}
+
+void Column::reserve(size_t count)
+{
+    Detach();
+    storage.reserve(count);
+}
+
+double* Column::Overwrite(size_t count)
+{
+    view = nullptr;
+    viewSize = 0;
+    storage.resize(count);
+    return storage.data();
+}
+
+void Column::View(const double* values, size_t count)
+{
+    storage.clear();
+    storage.shrink_to_fit();
+    view = values;
+    viewSize = count;
+}
+
+void Column::Detach()
+{
+    if (view == nullptr)
+        return;
+
+    storage.assign(view, view + viewSize);
+    view = nullptr;
+    viewSize = 0;
+}
+
+void DataStore::PushData(const DataFrame& df)
+{
+    if (packed)
+        Decompress();
+
+    const bool tracked = HasExtents();
+
+    date.push_back(df.date);
+    open.push_back(df.open);
+    close.push_back(df.close);
+    high.push_back(df.high);
+    low.push_back(df.low);
+    volume.push_back(df.volume);
+
+    maximum = std::max(df.high, maximum);
+    minimum = std::min(df.low , minimum);
+
+    // stale extents are left for the next BuildExtents
+    if (tracked == false)
+        return;
+
+    const size_t block = (size() - 1) / EXTENT_BLOCK;
+    if (block == blockLow.size())
+    {
+        blockLow.push_back(df.low);
+        blockHigh.push_back(df.high);
+    }
+    else
+    {
+        blockLow[block] = std::min(df.low, blockLow[block]);
+        blockHigh[block] = std::max(df.high, blockHigh[block]);
+    }
+}
+
+void DataStore::UpdateLast(const DataFrame& df)
+{
+    if (packed)
+        Decompress();
+
+    const size_t last = size() - 1;
+    const double oldHigh = high[last];
+    const double oldLow = low[last];
+
+    date.set(last, df.date);
+    open.set(last, df.open);
+    close.set(last, df.close);
+    high.set(last, df.high);
+    low.set(last, df.low);
+    volume.set(last, df.volume);
+    ++rewrites;
+
+    // a forming bar only ever widens, a corrected one can narrow and give back an extreme
+    const bool narrowed = df.high < oldHigh || df.low > oldLow;
+
+    if (HasExtents())
+    {
+        const size_t block = last / EXTENT_BLOCK;
+        if (narrowed)
+        {
+            blockLow[block] = DBL_MAX;
+            blockHigh[block] = -DBL_MAX;
+            for (size_t i = block * EXTENT_BLOCK; i <= last; ++i)
+            {
+                blockLow[block] = std::min(low[i], blockLow[block]);
+                blockHigh[block] = std::max(high[i], blockHigh[block]);
+            }
+        }
+        else
+        {
+            blockLow[block] = std::min(df.low, blockLow[block]);
+            blockHigh[block] = std::max(df.high, blockHigh[block]);
+        }
+    }
+
+    if (narrowed && (oldHigh >= maximum || oldLow <= minimum))
+    {
+        if (HasExtents())
+        {
+            RangeExtent(0, size(), minimum, maximum);
+            return;
+        }
+        minimum = DBL_MAX;
+        maximum = -DBL_MAX;
+        for (size_t i = 0; i <= last; ++i)
+        {
+            minimum = std::min(low[i], minimum);
+            maximum = std::max(high[i], maximum);
+        }
+        return;
+    }
+
+    maximum = std::max(df.high, maximum);
+    minimum = std::min(df.low , minimum);
+}
+
+void DataStore::Append(const DataStore& other)
+{
+    if (other.packed)
+    {
+        DataStore unpacked = other;
+        unpacked.Decompress();
+        Append(unpacked);
+        return;
+    }
+    if (packed)
+        Decompress();
+
+    date.append(other.date);
+    open.append(other.open);
+    close.append(other.close);
+    high.append(other.high);
+    low.append(other.low);
+    volume.append(other.volume);
+
+    maximum = std::max(other.maximum, maximum);
+    minimum = std::min(other.minimum, minimum);
+
+    BuildExtents();
+}
+
+size_t DataStore::Rows() const
+{
+    return packed ? packed->size() : size();
+}
+
+void DataStore::Compress()
+{
+    if (packed)
+        return;
+
+    if (size() != 0)
+        packed = std::make_shared<const CompressedStore>(*this);
+
+    date = Column();
+    open = Column();
+    close = Column();
+    high = Column();
+    low = Column();
+    volume = Column();
+    blockLow = std::vector<double>();
+    blockHigh = std::vector<double>();
+}
+
+void DataStore::Decompress()
+{
+    if (packed == nullptr)
+        return;
+
+    const std::shared_ptr<const CompressedStore> source = std::move(packed);
+    packed = nullptr;
+    source->Decode(0, source->size(), *this);
+}
+
+void DataStore::BuildExtents()
+{
+    const size_t count = size();
+    const size_t blocks = (count + EXTENT_BLOCK - 1) / EXTENT_BLOCK;
+    blockLow.assign(blocks, DBL_MAX);
+    blockHigh.assign(blocks, -DBL_MAX);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t block = i / EXTENT_BLOCK;
+        blockLow[block] = std::min(low[i], blockLow[block]);
+        blockHigh[block] = std::max(high[i], blockHigh[block]);
+    }
+}
+
+void DataStore::RangeExtent(size_t first, size_t last, double& outMin, double& outMax) const
+{
+    outMin = DBL_MAX;
+    outMax = -DBL_MAX;
+
+    size_t i = first;
+    // partial block at the front, whole blocks, then the partial tail
+    for (; i < last && i % EXTENT_BLOCK != 0; ++i)
+    {
+        outMin = std::min(low[i], outMin);
+        outMax = std::max(high[i], outMax);
+    }
+    for (; i + EXTENT_BLOCK <= last; i += EXTENT_BLOCK)
+    {
+        const size_t block = i / EXTENT_BLOCK;
+        outMin = std::min(blockLow[block], outMin);
+        outMax = std::max(blockHigh[block], outMax);
+    }
+    for (; i < last; ++i)
+    {
+        outMin = std::min(low[i], outMin);
+        outMax = std::max(high[i], outMax);
+    }
+}
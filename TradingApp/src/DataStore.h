@@ -0,0 +1,107 @@
+#pragma once
+#include "Memory.h"
+#include <cfloat>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class CompressedStore;
+
+struct DataFrame
+{
+	double date{};
+	double open{};
+	double close{};
+	double high{};
+	double low{};
+	double volume{};
+
+	void Print();
+};
+
+// Column of doubles that either owns its values or views memory owned elsewhere,
+// such as a mapped market cache. Writing to a viewing column copies it first.
+// Owned values are counted as market data memory.
+class Column
+{
+public:
+	Column() = default;
+	// a pmr copy would otherwise fall back to the default resource
+	Column(const Column& other) : storage{ other.storage, other.storage.get_allocator() }, view{ other.view }, viewSize{ other.viewSize } {}
+	Column(Column&&) = default;
+	Column& operator=(const Column&) = default;
+	Column& operator=(Column&&) = default;
+
+	const double* data() const { return view ? view : storage.data(); }
+	size_t size() const { return view ? viewSize : storage.size(); }
+	bool empty() const { return size() == 0; }
+
+	const double* begin() const { return data(); }
+	const double* end() const { return data() + size(); }
+	double front() const { return data()[0]; }
+	double back() const { return data()[size() - 1]; }
+	double operator[](size_t i) const { return data()[i]; }
+
+	void push_back(double value);
+	void set(size_t i, double value);
+	void append(const Column& other);
+	void reserve(size_t count);
+	// drops the values and returns count writable ones, for bulk decoding
+	double* Overwrite(size_t count);
+
+	void View(const double* values, size_t count);
+	bool IsView() const { return view != nullptr; }
+
+private:
+	void Detach();
+
+	std::pmr::vector<double> storage{ Memory::Tracked(MemoryTag::MarketData) };
+	const double* view{ nullptr };
+	size_t viewSize{};
+};
+
+struct DataStore
+{
+	std::string name;
+	Column date;
+	Column open;
+	Column close;
+	Column high;
+	Column low;
+	Column volume;
+
+	double maximum{-DBL_MAX };
+	double minimum{ DBL_MAX };
+
+	// bumped by UpdateLast, derived series compare it to redo the newest row they read
+	uint64_t rewrites{};
+
+	// low/high per block of rows so range min/max queries only touch a few entries
+	static constexpr size_t EXTENT_BLOCK = 64;
+	std::vector<double> blockLow;
+	std::vector<double> blockHigh;
+
+	// Set while the history is held compressed, the columns are empty then.
+	// Writes decompress first, like writes to a viewing column copy it.
+	std::shared_ptr<const CompressedStore> packed;
+
+	void PushData(const DataFrame& df);
+	// overwrites the newest row, for bars that are still forming or corrected by a refresh
+	void UpdateLast(const DataFrame& df);
+	void Append(const DataStore& other);
+	size_t size() const { return date.size(); };
+	// rows whether compressed or not
+	size_t Rows() const;
+
+	// encodes the columns and releases them, views included
+	void Compress();
+	void Decompress();
+	bool IsCompressed() const { return packed != nullptr; }
+
+	// rebuilds block extents, needed after columns were filled without PushData
+	void BuildExtents();
+	bool HasExtents() const { return blockLow.size() == (size() + EXTENT_BLOCK - 1) / EXTENT_BLOCK; }
+	// lowest low and highest high over rows [first, last)
+	void RangeExtent(size_t first, size_t last, double& outMin, double& outMax) const;
+};
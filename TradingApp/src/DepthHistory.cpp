@@ -0,0 +1,186 @@
+#include "DepthHistory.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	// count, level mask and two 10 byte varints per level, for each side
+	constexpr size_t MAX_SIDE_BYTES = 1 + 5 + DepthLevels::MAX_LEVELS * 20;
+	constexpr size_t MAX_RECORD_BYTES = 2 * MAX_SIDE_BYTES;
+
+	uint8_t* WriteVarint(uint8_t* out, uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			*out++ = (uint8_t)(value | 0x80);
+			value >>= 7;
+		}
+		*out++ = (uint8_t)value;
+		return out;
+	}
+
+	const uint8_t* ReadVarint(const uint8_t* in, uint64_t& outValue)
+	{
+		outValue = 0;
+		for (unsigned shift = 0; ; shift += 7)
+		{
+			const uint8_t byte = *in++;
+			outValue |= (uint64_t)(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				return in;
+		}
+	}
+
+	uint64_t ZigZag(int64_t value)
+	{
+		return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+	}
+
+	int64_t UnZigZag(uint64_t value)
+	{
+		return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+	}
+
+	// levels below the base's count are compared against the same level of the base,
+	// deeper ones against zero
+	LevelInfo BaseLevel(const DepthLevels& base, size_t i)
+	{
+		return i < base.count ? base.levels[i] : LevelInfo{ 0, 0 };
+	}
+
+	// level count, mask of levels that differ from base, then price and quantity deltas of those;
+	// base may be outState
+	uint8_t* EncodeSide(uint8_t* out, const LevelInfo* levels, uint32_t count, const DepthLevels& base, DepthLevels& outState)
+	{
+		uint64_t mask = 0;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const LevelInfo previous = BaseLevel(base, i);
+			if (i >= base.count || levels[i].price != previous.price || levels[i].quantity != previous.quantity)
+				mask |= uint64_t(1) << i;
+		}
+
+		*out++ = (uint8_t)count;
+		out = WriteVarint(out, mask);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if ((mask & (uint64_t(1) << i)) == 0)
+				continue;
+			const LevelInfo previous = BaseLevel(base, i);
+			out = WriteVarint(out, ZigZag((int64_t)levels[i].price - previous.price));
+			out = WriteVarint(out, ZigZag((int64_t)levels[i].quantity - previous.quantity));
+		}
+
+		outState.count = count;
+		std::copy(levels, levels + count, outState.levels);
+		return out;
+	}
+
+	const uint8_t* DecodeSide(const uint8_t* in, DepthLevels& state)
+	{
+		const uint32_t count = *in++;
+		uint64_t mask = 0;
+		in = ReadVarint(in, mask);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if ((mask & (uint64_t(1) << i)) == 0)
+				continue;
+			const LevelInfo previous = BaseLevel(state, i);
+			uint64_t price = 0, quantity = 0;
+			in = ReadVarint(in, price);
+			in = ReadVarint(in, quantity);
+			state.levels[i].price = (Price)(previous.price + UnZigZag(price));
+			state.levels[i].quantity = (Quantity)(previous.quantity + UnZigZag(quantity));
+		}
+		state.count = count;
+		return in;
+	}
+}
+
+DepthHistory::DepthHistory(size_t _levels, size_t capacityBytes, size_t maxSnapshots)
+	: levels{ std::clamp<size_t>(_levels, 1, DepthLevels::MAX_LEVELS) }
+{
+	// offsets are 32 bit and a record always has to fit
+	bytes.resize(std::clamp<size_t>(capacityBytes, MAX_RECORD_BYTES, UINT32_MAX));
+	entries.resize(std::max<size_t>(maxSnapshots, 1));
+	// at least one keyframe has to survive in a short ring
+	keyframeInterval = (uint32_t)std::clamp<size_t>(entries.size() / 2, 1, KEYFRAME_INTERVAL);
+}
+
+void DepthHistory::Record(uint64_t time, const LevelInfo* bids, size_t numBids, const LevelInfo* asks, size_t numAsks)
+{
+	PROFILE_SCOPE("DepthHistory::Record");
+	static const DepthLevels empty;
+	const bool keyframe = sinceKeyframe == 0;
+
+	uint8_t record[MAX_RECORD_BYTES];
+	uint8_t* end = EncodeSide(record, bids, (uint32_t)std::min(numBids, levels), keyframe ? empty : previousBids, previousBids);
+	end = EncodeSide(end, asks, (uint32_t)std::min(numAsks, levels), keyframe ? empty : previousAsks, previousAsks);
+	const size_t size = end - record;
+
+	// a record never straddles the end, the tail is skipped instead
+	const size_t start = writeOffset + size > bytes.size() ? 0 : writeOffset;
+	const bool wrapped = start < writeOffset;
+
+	// the oldest snapshots sit right after the write position, drop those the new record passes over
+	while (count > 0)
+	{
+		const Entry& entry = entries[oldest];
+		const bool overwritten = wrapped
+			? entry.offset >= writeOffset || entry.offset < start + size
+			: entry.offset >= writeOffset && entry.offset < start + size;
+		if (overwritten == false && count < entries.size())
+			break;
+		oldest = (oldest + 1) % entries.size();
+		--count;
+	}
+
+	std::memcpy(bytes.data() + start, record, size);
+	entries[(oldest + count) % entries.size()] = Entry{ time, (uint32_t)start, (uint32_t)size, keyframe };
+	++count;
+	writeOffset = start + size;
+	sinceKeyframe = (sinceKeyframe + 1) % keyframeInterval;
+	++recorded;
+}
+
+void DepthHistory::Sample(uint64_t time, OrderBook& book)
+{
+	size_t numBids = 0, numAsks = 0;
+	book.TopLevels(levels, sampleBids, numBids, sampleAsks, numAsks);
+	Record(time, sampleBids, numBids, sampleAsks, numAsks);
+}
+
+void DepthHistory::ForEach(const std::function<void(const DepthSnapshot&)>& fn) const
+{
+	DepthSnapshot snapshot;
+	bool started = false;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Entry& entry = entries[(oldest + i) % entries.size()];
+		// deltas whose keyframe was dropped cannot be rebuilt
+		if (started == false && entry.keyframe == false)
+			continue;
+		started = true;
+
+		if (entry.keyframe)
+		{
+			snapshot.bids.count = 0;
+			snapshot.asks.count = 0;
+		}
+		const uint8_t* in = bytes.data() + entry.offset;
+		in = DecodeSide(in, snapshot.bids);
+		DecodeSide(in, snapshot.asks);
+		snapshot.time = entry.time;
+		fn(snapshot);
+	}
+}
+
+void DepthHistory::Clear()
+{
+	oldest = 0;
+	count = 0;
+	writeOffset = 0;
+	sinceKeyframe = 0;
+	recorded = 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "Memory.h"
+#include "Orderbook.h"
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+
+// one side of the book, best level first
+struct DepthLevels
+{
+	static constexpr size_t MAX_LEVELS = 32;
+
+	uint32_t count{};
+	LevelInfo levels[MAX_LEVELS]{};
+};
+
+struct DepthSnapshot
+{
+	uint64_t time{};
+	DepthLevels bids;
+	DepthLevels asks;
+};
+
+// Top of book depth over time, in a byte ring and an index ring that are both
+// allocated up front, so memory stays fixed however long the session runs.
+// Each snapshot is stored as the levels that changed against the previous one.
+// Every KEYFRAME_INTERVAL-th snapshot, more often in short rings, is encoded
+// against an empty book, so the oldest snapshots can be dropped and reading
+// restarts at the next keyframe.
+// Record costs O(levels) and never allocates.
+class DepthHistory
+{
+public:
+	static constexpr uint32_t KEYFRAME_INTERVAL = 64;
+
+	DepthHistory(size_t _levels = 16, size_t capacityBytes = 4 << 20, size_t maxSnapshots = 1 << 16);
+
+	// levels beyond the configured depth are ignored
+	void Record(uint64_t time, const LevelInfo* bids, size_t numBids, const LevelInfo* asks, size_t numAsks);
+	// reads the book's top levels and records them
+	void Sample(uint64_t time, OrderBook& book);
+
+	// decodes every readable snapshot, oldest first
+	void ForEach(const std::function<void(const DepthSnapshot&)>& fn) const;
+
+	size_t Levels() const { return levels; }
+	size_t Size() const { return count; }
+	size_t CapacityBytes() const { return bytes.size(); }
+	uint64_t Recorded() const { return recorded; }
+	void Clear();
+
+private:
+	struct Entry
+	{
+		uint64_t time{};
+		uint32_t offset{};
+		uint32_t size{};
+		bool keyframe{};
+	};
+
+	size_t levels;
+	std::pmr::vector<uint8_t> bytes{ Memory::Tracked(MemoryTag::DepthHistory) };
+	std::pmr::vector<Entry> entries{ Memory::Tracked(MemoryTag::DepthHistory) };
+
+	size_t oldest{};      // index into entries
+	size_t count{};
+	size_t writeOffset{};
+	uint64_t recorded{};
+	uint32_t sinceKeyframe{};
+	uint32_t keyframeInterval;
+
+	// the last recorded snapshot, what the next one is encoded against
+	DepthLevels previousBids;
+	DepthLevels previousAsks;
+
+	// scratch for the book's top levels in Sample
+	LevelInfo sampleBids[DepthLevels::MAX_LEVELS]{};
+	LevelInfo sampleAsks[DepthLevels::MAX_LEVELS]{};
+};
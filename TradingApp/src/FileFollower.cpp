@@ -0,0 +1,192 @@
+#include "FileFollower.h"
+#include "CsvLoader.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX   /* don't define min() and max(). */
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// how often the watcher wakes up to check for a stop request
+	constexpr int WAKE_MS = 200;
+}
+
+bool FileFollower::Start(const char* _fileName, uint64_t _offset, std::function<void()> _onRows)
+{
+	Stop();
+
+	std::error_code error;
+	if (std::filesystem::exists(_fileName, error) == false)
+		return false;
+
+	fileName = _fileName;
+	offset = _offset;
+	onRows = std::move(_onRows);
+	partial.clear();
+
+	running = true;
+	thread = std::jthread([this](std::stop_token stop) { Watch(stop); });
+	return true;
+}
+
+void FileFollower::Stop()
+{
+	if (thread.joinable())
+	{
+		thread.request_stop();
+		thread.join();
+	}
+	running = false;
+}
+
+size_t FileFollower::Drain(std::vector<FollowedRow>& outRows)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const size_t count = pending.size();
+	outRows.insert(outRows.end(), std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.end()));
+	pending.clear();
+	return count;
+}
+
+void FileFollower::Watch(std::stop_token stop)
+{
+	PROFILE_THREAD("Follower");
+	auto read = [this] {
+		if (ReadAppended() && onRows)
+			onRows();
+	};
+
+	// rows written between the initial load and now
+	read();
+
+#ifdef _WIN32
+	std::filesystem::path directory = std::filesystem::path(fileName).parent_path();
+	if (directory.empty())
+		directory = ".";
+	HANDLE change = FindFirstChangeNotificationW(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+	if (change == INVALID_HANDLE_VALUE)
+	{
+		std::printf("Cannot watch %s\n", fileName.c_str());
+		running = false;
+		return;
+	}
+
+	while (stop.stop_requested() == false)
+	{
+		if (WaitForSingleObject(change, WAKE_MS) == WAIT_OBJECT_0)
+		{
+			read();
+			FindNextChangeNotification(change);
+		}
+	}
+	FindCloseChangeNotification(change);
+#elif defined(__linux__)
+	int notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notify < 0 || inotify_add_watch(notify, fileName.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0)
+	{
+		std::printf("Cannot watch %s: %s\n", fileName.c_str(), std::strerror(errno));
+		if (notify >= 0)
+			close(notify);
+		running = false;
+		return;
+	}
+
+	while (stop.stop_requested() == false)
+	{
+		pollfd events{ notify, POLLIN, 0 };
+		if (poll(&events, 1, WAKE_MS) > 0)
+		{
+			// only whether something changed matters, not the individual events
+			char buffer[4096];
+			while (::read(notify, buffer, sizeof(buffer)) > 0)
+			{
+			}
+			read();
+		}
+	}
+	close(notify);
+#else
+	while (stop.stop_requested() == false)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(WAKE_MS));
+		read();
+	}
+#endif
+}
+
+bool FileFollower::ReadAppended()
+{
+	PROFILE_SCOPE("FileFollower::ReadAppended");
+	std::error_code error;
+	const uint64_t size = std::filesystem::file_size(fileName, error);
+	if (error || size == offset)
+		return false;
+
+	if (size < offset)
+	{
+		// only appends can be followed, pick up again from the new end
+		std::printf("%s shrank, following from its new end\n", fileName.c_str());
+		offset = size;
+		partial.clear();
+		return false;
+	}
+
+	std::ifstream file(fileName, std::ios::binary);
+	if (file.is_open() == false)
+		return false;
+
+	// the buffer only starts at the file's first byte before anything was consumed
+	const bool skipHeader = offset == partial.size();
+	const size_t kept = partial.size();
+	partial.resize(kept + (size_t)(size - offset));
+	file.seekg((std::streamoff)offset);
+	file.read(partial.data() + kept, (std::streamsize)(size - offset));
+	const size_t got = (size_t)file.gcount();
+	partial.resize(kept + got);
+	offset += got;
+
+	// everything up to the last newline is complete, the rest waits for the writer
+	const size_t complete = partial.rfind('\n');
+	if (complete == std::string::npos)
+		return false;
+
+	std::vector<FollowedRow> rows;
+	const char* cursor = partial.data();
+	const char* end = partial.data() + complete + 1;
+	if (skipHeader)
+		cursor = std::min(end, static_cast<const char*>(std::memchr(cursor, '\n', end - cursor)) + 1);
+
+	while (cursor < end)
+	{
+		DataFrame df{};
+		std::string_view name;
+		if (ParseCsvRow(cursor, end, df, name))
+			rows.push_back(FollowedRow{ std::string(name), df });
+	}
+	partial.erase(0, complete + 1);
+
+	if (rows.empty())
+		return false;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	pending.insert(pending.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+	return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "DataStore.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FollowedRow
+{
+	std::string name;
+	DataFrame frame;
+};
+
+// Watches a CSV that is only ever appended to and parses the bytes added since the last read.
+// Change notification comes from inotify on Linux and a directory change handle on Windows,
+// other platforms poll the file size. Rows are parsed on the watcher thread and queue up
+// until the owner drains them, so the owner decides when its stores are modified.
+class FileFollower
+{
+public:
+	~FileFollower() { Stop(); }
+
+	// follows fileName from byte offset, onRows runs on the watcher thread after rows were queued
+	bool Start(const char* fileName, uint64_t offset, std::function<void()> onRows = {});
+	void Stop();
+	bool Running() const { return running; }
+
+	// moves every row parsed since the previous call into outRows, returns how many
+	size_t Drain(std::vector<FollowedRow>& outRows);
+
+private:
+	void Watch(std::stop_token stop);
+	// parses complete lines past offset, keeps a trailing partial line for the next read
+	bool ReadAppended();
+
+	std::string fileName;
+	uint64_t offset{};
+	std::string partial;
+	std::function<void()> onRows;
+
+	std::mutex mutex;
+	std::vector<FollowedRow> pending;
+
+	std::atomic<bool> running{ false };
+	std::jthread thread;
+};
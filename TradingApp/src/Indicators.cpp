@@ -0,0 +1,593 @@
+#include "Indicators.h"
+#include "Cpu.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#define INDICATORS_AVX2 CPU_X64
+
+namespace
+{
+	constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+	// first row whose inputs reach back period - 1 rows before from
+	size_t WindowStart(size_t from, uint32_t period)
+	{
+		return from + 1 >= period ? from + 1 - period : 0;
+	}
+
+#if INDICATORS_AVX2
+	// the vector halves of the kernels below, each returns the first row it left to the scalar loop
+
+	AVX2_TARGET size_t MultiplyAvx2(const double* a, const double* b, size_t count, double* out)
+	{
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			_mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+		}
+		return i;
+	}
+
+	AVX2_TARGET size_t TypicalPriceVolumeAvx2(const double* h, const double* l, const double* c, const double* v, size_t count, double* out)
+	{
+		size_t i = 0;
+		const __m256d third = _mm256_set1_pd(1.0 / 3.0);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m256d tp = _mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(h + i), _mm256_loadu_pd(l + i)), _mm256_loadu_pd(c + i));
+			_mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_mul_pd(tp, third), _mm256_loadu_pd(v + i)));
+		}
+		return i;
+	}
+
+	AVX2_TARGET size_t TrueRangeAvx2(const double* h, const double* l, const double* c, size_t begin, size_t i, size_t count, double* out)
+	{
+		const __m256d signMask = _mm256_set1_pd(-0.0);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m256d hi = _mm256_loadu_pd(h + i);
+			__m256d lo = _mm256_loadu_pd(l + i);
+			__m256d pc = _mm256_loadu_pd(c + i - 1);
+			__m256d range = _mm256_sub_pd(hi, lo);
+			__m256d up = _mm256_andnot_pd(signMask, _mm256_sub_pd(hi, pc));
+			__m256d down = _mm256_andnot_pd(signMask, _mm256_sub_pd(lo, pc));
+			_mm256_storeu_pd(out + i - begin, _mm256_max_pd(range, _mm256_max_pd(up, down)));
+		}
+		return i;
+	}
+
+	AVX2_TARGET size_t GainLossAvx2(const double* x, size_t begin, size_t count, double* outGain, double* outLoss)
+	{
+		size_t i = begin;
+		const __m256d zero = _mm256_setzero_pd();
+		for (; i + 4 <= count; i += 4)
+		{
+			__m256d diff = _mm256_sub_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(x + i - 1));
+			_mm256_storeu_pd(outGain + i - begin, _mm256_max_pd(diff, zero));
+			_mm256_storeu_pd(outLoss + i - begin, _mm256_max_pd(_mm256_sub_pd(zero, diff), zero));
+		}
+		return i;
+	}
+
+	AVX2_TARGET size_t ScaleAvx2(double* out, size_t count, double scale)
+	{
+		size_t i = 0;
+		const __m256d s = _mm256_set1_pd(scale);
+		for (; i + 4 <= count; i += 4)
+		{
+			_mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(out + i), s));
+		}
+		return i;
+	}
+
+	template <bool IsMin>
+	AVX2_TARGET size_t CombineExtremesAvx2(const double* prefix, const double* suffix, size_t begin, uint32_t period, size_t i, size_t count, double* out)
+	{
+		for (; i + 4 <= count; i += 4)
+		{
+			__m256d s = _mm256_loadu_pd(suffix + (i + 1 - period - begin));
+			__m256d p = _mm256_loadu_pd(prefix + (i - begin));
+			_mm256_storeu_pd(out + i, IsMin ? _mm256_min_pd(s, p) : _mm256_max_pd(s, p));
+		}
+		return i;
+	}
+
+	AVX2_TARGET size_t BandsAvx2(const double* middle, double* upper, double* lower, size_t i, size_t count, double inv, double width)
+	{
+		const __m256d vInv = _mm256_set1_pd(inv);
+		const __m256d vWidth = _mm256_set1_pd(width);
+		const __m256d zero = _mm256_setzero_pd();
+		for (; i + 4 <= count; i += 4)
+		{
+			__m256d mean = _mm256_loadu_pd(middle + i);
+			__m256d meanSq = _mm256_mul_pd(_mm256_loadu_pd(upper + i), vInv);
+			__m256d var = _mm256_max_pd(_mm256_sub_pd(meanSq, _mm256_mul_pd(mean, mean)), zero);
+			__m256d band = _mm256_mul_pd(_mm256_sqrt_pd(var), vWidth);
+			_mm256_storeu_pd(upper + i, _mm256_add_pd(mean, band));
+			_mm256_storeu_pd(lower + i, _mm256_sub_pd(mean, band));
+		}
+		return i;
+	}
+#endif
+
+	// out[i] = a[i] * b[i]
+	void Multiply(const double* a, const double* b, size_t count, double* out)
+	{
+		size_t i = 0;
+#if INDICATORS_AVX2
+		if (Cpu::HasAvx2())
+			i = MultiplyAvx2(a, b, count, out);
+#endif
+		for (; i < count; ++i)
+		{
+			out[i] = a[i] * b[i];
+		}
+	}
+
+	// out[i] = (h[i] + l[i] + c[i]) / 3 * v[i]
+	void TypicalPriceVolume(const double* h, const double* l, const double* c, const double* v, size_t count, double* out)
+	{
+		size_t i = 0;
+#if INDICATORS_AVX2
+		if (Cpu::HasAvx2())
+			i = TypicalPriceVolumeAvx2(h, l, c, v, count, out);
+#endif
+		for (; i < count; ++i)
+		{
+			out[i] = (h[i] + l[i] + c[i]) * (1.0 / 3.0) * v[i];
+		}
+	}
+
+	// out[i - begin] = max(h - l, |h - prevClose|, |l - prevClose|), the first row has no previous close
+	void TrueRange(const double* h, const double* l, const double* c, size_t begin, size_t count, double* out)
+	{
+		size_t i = begin;
+		if (i == 0 && count > 0)
+		{
+			out[0] = h[0] - l[0];
+			i = 1;
+		}
+#if INDICATORS_AVX2
+		if (Cpu::HasAvx2())
+			i = TrueRangeAvx2(h, l, c, begin, i, count, out);
+#endif
+		for (; i < count; ++i)
+		{
+			out[i - begin] = std::max({ h[i] - l[i], std::abs(h[i] - c[i - 1]), std::abs(l[i] - c[i - 1]) });
+		}
+	}
+
+	// gains/losses of x[i] against x[i - 1] for i in [begin, count), begin >= 1
+	void GainLoss(const double* x, size_t begin, size_t count, double* outGain, double* outLoss)
+	{
+		size_t i = begin;
+#if INDICATORS_AVX2
+		if (Cpu::HasAvx2())
+			i = GainLossAvx2(x, begin, count, outGain, outLoss);
+#endif
+		for (; i < count; ++i)
+		{
+			const double diff = x[i] - x[i - 1];
+			outGain[i - begin] = std::max(diff, 0.0);
+			outLoss[i - begin] = std::max(-diff, 0.0);
+		}
+	}
+
+	// out[i] = sum of x over the period rows ending at i, for i in [from, count)
+	// x holds rows from base onwards, base must not be past WindowStart(from, period)
+	void SlidingSum(const double* x, size_t base, size_t count, size_t from, uint32_t period, double* out)
+	{
+		double sum = 0.0;
+		for (size_t i = WindowStart(from, period); i < from; ++i)
+		{
+			sum += x[i - base];
+		}
+		for (size_t i = from; i < count; ++i)
+		{
+			sum += x[i - base];
+			if (i > from && i >= period)
+				sum -= x[i - period - base];
+			out[i] = i + 1 >= period ? sum : NaN;
+		}
+	}
+
+	// out[i] *= scale
+	void Scale(double* out, size_t count, double scale)
+	{
+		size_t i = 0;
+#if INDICATORS_AVX2
+		if (Cpu::HasAvx2())
+			i = ScaleAvx2(out, count, scale);
+#endif
+		for (; i < count; ++i)
+		{
+			out[i] *= scale;
+		}
+	}
+
+	// van Herk/Gil-Werman: prefix and suffix extremes over period sized blocks,
+	// every window is then the combination of one suffix and one prefix value
+	template <bool IsMin>
+	void RollingExtreme(const double* x, size_t count, size_t from, uint32_t period, double* out)
+	{
+		if (from >= count)
+			return;
+
+		const size_t begin = WindowStart(from, period);
+		const size_t n = count - begin;
+		std::vector<double> prefix(n), suffix(n);
+
+		auto pick = [](double a, double b) { return IsMin ? std::min(a, b) : std::max(a, b); };
+
+		for (size_t blockStart = 0; blockStart < n; blockStart += period)
+		{
+			const size_t blockEnd = std::min<size_t>(blockStart + period, n);
+			prefix[blockStart] = x[begin + blockStart];
+			for (size_t j = blockStart + 1; j < blockEnd; ++j)
+			{
+				prefix[j] = pick(prefix[j - 1], x[begin + j]);
+			}
+			suffix[blockEnd - 1] = x[begin + blockEnd - 1];
+			for (size_t j = blockEnd - 1; j-- > blockStart;)
+			{
+				suffix[j] = pick(suffix[j + 1], x[begin + j]);
+			}
+		}
+
+		size_t i = std::max<size_t>(from, period - 1);
+		for (size_t j = from; j < std::min(i, count); ++j)
+		{
+			out[j] = NaN;
+		}
+
+#if INDICATORS_AVX2
+		if (Cpu::HasAvx2())
+			i = CombineExtremesAvx2<IsMin>(prefix.data(), suffix.data(), begin, period, i, count, out);
+#endif
+		for (; i < count; ++i)
+		{
+			out[i] = pick(suffix[i + 1 - period - begin], prefix[i - begin]);
+		}
+	}
+
+	// Wilder smoothing seeded with the mean of the first period values
+	void Wilder(const double* x, size_t xBegin, size_t count, size_t from, uint32_t period, double& state, double* out)
+	{
+		for (size_t i = from; i < count; ++i)
+		{
+			const double value = x[i - xBegin];
+			if (i + 1 < period)
+			{
+				state += value;
+				out[i] = NaN;
+			}
+			else if (i + 1 == period)
+			{
+				state = (state + value) / period;
+				out[i] = state;
+			}
+			else
+			{
+				state = (state * (period - 1) + value) / period;
+				out[i] = state;
+			}
+		}
+	}
+}
+
+namespace Indicators
+{
+	bool HasAvx2()
+	{
+		return INDICATORS_AVX2 != 0 && Cpu::HasAvx2();
+	}
+
+	void Sma(const double* x, size_t count, size_t from, uint32_t period, double* out)
+	{
+		SlidingSum(x, 0, count, from, period, out);
+		Scale(out + from, count - std::min(from, count), 1.0 / period);
+	}
+
+	void Ema(const double* x, size_t count, size_t from, uint32_t period, double* out)
+	{
+		const double alpha = 2.0 / (period + 1.0);
+		for (size_t i = from; i < count; ++i)
+		{
+			if (i + 1 < period)
+			{
+				out[i] = NaN;
+			}
+			else if (i + 1 == period)
+			{
+				// seeded with the simple average of the first period values
+				double sum = 0.0;
+				for (size_t j = 0; j < period; ++j)
+					sum += x[j];
+				out[i] = sum / period;
+			}
+			else
+			{
+				out[i] = out[i - 1] + alpha * (x[i] - out[i - 1]);
+			}
+		}
+	}
+
+	void Vwap(const double* high, const double* low, const double* close, const double* volume, size_t count, size_t from, uint32_t period, double* out)
+	{
+		if (from >= count)
+			return;
+
+		const size_t begin = WindowStart(from, period);
+		const size_t n = count - begin;
+		std::vector<double> tpv(n);
+		TypicalPriceVolume(high + begin, low + begin, close + begin, volume + begin, n, tpv.data());
+
+		double priceVolume = 0.0;
+		double totalVolume = 0.0;
+		for (size_t i = begin; i < from; ++i)
+		{
+			priceVolume += tpv[i - begin];
+			totalVolume += volume[i];
+		}
+		for (size_t i = from; i < count; ++i)
+		{
+			priceVolume += tpv[i - begin];
+			totalVolume += volume[i];
+			if (i > from && i >= period)
+			{
+				priceVolume -= tpv[i - period - begin];
+				totalVolume -= volume[i - period];
+			}
+			out[i] = i + 1 >= period && totalVolume > 0.0 ? priceVolume / totalVolume : NaN;
+		}
+	}
+
+	void Bollinger(const double* x, size_t count, size_t from, uint32_t period, double width, double* outMiddle, double* outUpper, double* outLower)
+	{
+		if (from >= count)
+			return;
+
+		const size_t begin = WindowStart(from, period);
+		const size_t n = count - begin;
+		std::vector<double> squares(n);
+		Multiply(x + begin, x + begin, n, squares.data());
+
+		Sma(x, count, from, period, outMiddle);
+		// mean of squares lands in outUpper then becomes the band
+		SlidingSum(squares.data(), begin, count, from, period, outUpper);
+
+		const double inv = 1.0 / period;
+		size_t i = from;
+#if INDICATORS_AVX2
+		if (Cpu::HasAvx2())
+			i = BandsAvx2(outMiddle, outUpper, outLower, i, count, inv, width);
+#endif
+		for (; i < count; ++i)
+		{
+			const double mean = outMiddle[i];
+			const double var = std::max(outUpper[i] * inv - mean * mean, 0.0);
+			const double band = std::sqrt(var) * width;
+			outUpper[i] = mean + band;
+			outLower[i] = mean - band;
+		}
+	}
+
+	void Rsi(const double* x, size_t count, size_t from, uint32_t period, double& avgGain, double& avgLoss, double* out)
+	{
+		if (from >= count)
+			return;
+
+		if (from == 0)
+		{
+			out[0] = NaN;
+			avgGain = avgLoss = 0.0;
+			from = 1;
+		}
+
+		const size_t n = count - from;
+		std::vector<double> gains(n), losses(n);
+		GainLoss(x, from, count, gains.data(), losses.data());
+
+		// smoothing runs over gain rows 1..count-1, i.e. period gains make the first value
+		for (size_t i = from; i < count; ++i)
+		{
+			const double gain = gains[i - from];
+			const double loss = losses[i - from];
+			if (i < period)
+			{
+				avgGain += gain;
+				avgLoss += loss;
+				out[i] = NaN;
+				continue;
+			}
+
+			if (i == period)
+			{
+				avgGain = (avgGain + gain) / period;
+				avgLoss = (avgLoss + loss) / period;
+			}
+			else
+			{
+				avgGain = (avgGain * (period - 1) + gain) / period;
+				avgLoss = (avgLoss * (period - 1) + loss) / period;
+			}
+			out[i] = avgLoss > 0.0 ? 100.0 - 100.0 / (1.0 + avgGain / avgLoss) : 100.0;
+		}
+	}
+
+	void Atr(const double* high, const double* low, const double* close, size_t count, size_t from, uint32_t period, double* out)
+	{
+		if (from >= count)
+			return;
+
+		std::vector<double> ranges(count - from);
+		TrueRange(high, low, close, from, count, ranges.data());
+
+		// the previous atr is the smoothing state, before the first value it is the running sum
+		double state = 0.0;
+		if (from + 1 > period)
+		{
+			state = out[from - 1];
+		}
+		else if (from > 0)
+		{
+			std::vector<double> head(from);
+			TrueRange(high, low, close, 0, from, head.data());
+			for (double range : head)
+				state += range;
+		}
+		Wilder(ranges.data(), from, count, from, period, state, out);
+	}
+
+	void RollingMin(const double* x, size_t count, size_t from, uint32_t period, double* out)
+	{
+		RollingExtreme<true>(x, count, from, period, out);
+	}
+
+	void RollingMax(const double* x, size_t count, size_t from, uint32_t period, double* out)
+	{
+		RollingExtreme<false>(x, count, from, period, out);
+	}
+}
+
+void IndicatorSeries::Update(const DataStore& ds)
+{
+	const size_t count = ds.size();
+	if (count < computed)
+	{
+		// source shrank or was reloaded, start over
+		computed = 0;
+		avgGain = avgLoss = 0.0;
+	}
+	if (rewrites != ds.rewrites)
+	{
+		// the newest row read last time was overwritten in place, it is computed again
+		rewrites = ds.rewrites;
+		if (computed > 0)
+		{
+			--computed;
+			avgGain = settledGain;
+			avgLoss = settledLoss;
+		}
+	}
+	if (computed == count)
+		return;
+
+	const uint32_t period = std::max<uint32_t>(spec.period, 1);
+	const size_t from = computed;
+
+	// grow with headroom so a stream of appends does not reallocate every time
+	auto grow = [count](std::vector<double>& column) {
+		if (column.capacity() < count)
+			column.reserve(count + count / 4);
+		column.resize(count);
+	};
+	grow(values);
+
+	switch (spec.type)
+	{
+	case IndicatorType::SMA:
+		Indicators::Sma(ds.close.data(), count, from, period, values.data());
+		break;
+	case IndicatorType::EMA:
+		Indicators::Ema(ds.close.data(), count, from, period, values.data());
+		break;
+	case IndicatorType::VWAP:
+		Indicators::Vwap(ds.high.data(), ds.low.data(), ds.close.data(), ds.volume.data(), count, from, period, values.data());
+		break;
+	case IndicatorType::Bollinger:
+		grow(upper);
+		grow(lower);
+		Indicators::Bollinger(ds.close.data(), count, from, period, spec.width, values.data(), upper.data(), lower.data());
+		break;
+	case IndicatorType::RSI:
+		// the newest row goes in on its own so the state before it is kept
+		if (from + 1 < count)
+			Indicators::Rsi(ds.close.data(), count - 1, from, period, avgGain, avgLoss, values.data());
+		settledGain = avgGain;
+		settledLoss = avgLoss;
+		Indicators::Rsi(ds.close.data(), count, std::max(from, count - 1), period, avgGain, avgLoss, values.data());
+		break;
+	case IndicatorType::ATR:
+		Indicators::Atr(ds.high.data(), ds.low.data(), ds.close.data(), count, from, period, values.data());
+		break;
+	case IndicatorType::RollingMin:
+		Indicators::RollingMin(ds.low.data(), count, from, period, values.data());
+		break;
+	case IndicatorType::RollingMax:
+		Indicators::RollingMax(ds.high.data(), count, from, period, values.data());
+		break;
+	default:
+		break;
+	}
+
+	computed = count;
+}
+
+const IndicatorSeries& IndicatorCache::Get(SymbolID id, const DataStore& ds, IndicatorSpec spec)
+{
+	if (series.size() <= id)
+		series.resize(id + 1);
+
+	IndicatorSeries& result = Find(id, spec);
+	if (ds.IsCompressed() == false)
+		result.Update(ds);
+	return result;
+}
+
+size_t IndicatorCache::UpdateAll(const MarketData& data, IndicatorSpec spec, unsigned numThreads)
+{
+	PROFILE_SCOPE("Indicators::UpdateAll");
+	const size_t count = data.Count();
+	if (series.size() < count)
+		series.resize(count);
+
+	// create entries up front so workers never touch the containers,
+	// compressed symbols have no columns to read and keep their old results
+	std::vector<IndicatorSeries*> targets(count);
+	size_t compressed = 0;
+	for (SymbolID id = 0; id < (SymbolID)count; ++id)
+	{
+		if (data.Get(id).IsCompressed())
+		{
+			++compressed;
+			continue;
+		}
+		targets[id] = &Find(id, spec);
+	}
+
+	if (numThreads == 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<std::jthread> workers;
+	workers.reserve(numThreads);
+	for (unsigned t = 0; t < numThreads; ++t)
+	{
+		workers.emplace_back([&, t] {
+			PROFILE_THREAD("Indicator worker");
+			PROFILE_SCOPE("Indicators::Update");
+			for (size_t id = t; id < count; id += numThreads)
+			{
+				if (targets[id])
+					targets[id]->Update(data.Get((SymbolID)id));
+			}
+		});
+	}
+	return compressed;
+}
+
+IndicatorSeries& IndicatorCache::Find(SymbolID id, IndicatorSpec spec)
+{
+	auto& symbolSeries = series[id];
+	auto it = std::find_if(symbolSeries.begin(), symbolSeries.end(),
+		[&spec](const IndicatorSeries& s) { return s.spec == spec; });
+	if (it != symbolSeries.end())
+		return *it;
+
+	IndicatorSeries& created = symbolSeries.emplace_back();
+	created.spec = spec;
+	return created;
+}
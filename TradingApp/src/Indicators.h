@@ -0,0 +1,83 @@
+#pragma once
+#include "MarketData.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Technical indicator kernels over DataStore columns.
+// Every kernel fills out[from, count) of a caller allocated buffer so appended rows
+// only cost their own slots; rows without enough history are NaN.
+// Element-wise stages pick their AVX2 versions at run time when the CPU has it,
+// recurrences stay scalar.
+namespace Indicators
+{
+	void Sma(const double* x, size_t count, size_t from, uint32_t period, double* out);
+	void Ema(const double* x, size_t count, size_t from, uint32_t period, double* out);
+	void Vwap(const double* high, const double* low, const double* close, const double* volume, size_t count, size_t from, uint32_t period, double* out);
+	void Bollinger(const double* x, size_t count, size_t from, uint32_t period, double width, double* outMiddle, double* outUpper, double* outLower);
+	void Rsi(const double* x, size_t count, size_t from, uint32_t period, double& avgGain, double& avgLoss, double* out);
+	void Atr(const double* high, const double* low, const double* close, size_t count, size_t from, uint32_t period, double* out);
+	void RollingMin(const double* x, size_t count, size_t from, uint32_t period, double* out);
+	void RollingMax(const double* x, size_t count, size_t from, uint32_t period, double* out);
+
+	// the vector kernels are in use on this CPU
+	bool HasAvx2();
+}
+
+enum class IndicatorType
+{
+	SMA,
+	EMA,
+	VWAP,
+	Bollinger,
+	RSI,
+	ATR,
+	RollingMin,
+	RollingMax
+};
+
+struct IndicatorSpec
+{
+	IndicatorType type{ IndicatorType::SMA };
+	uint32_t period{ 20 };
+	double width{ 2.0 }; // bollinger band width in standard deviations
+
+	bool operator==(const IndicatorSpec& other) const = default;
+};
+
+struct IndicatorSeries
+{
+	IndicatorSpec spec;
+	std::vector<double> values; // middle band for bollinger
+	std::vector<double> upper;  // bollinger only
+	std::vector<double> lower;  // bollinger only
+
+	size_t computed{};
+	uint64_t rewrites{}; // DataStore::rewrites when computed was last advanced
+	double avgGain{}; // rsi smoothing state
+	double avgLoss{};
+	double settledGain{}; // rsi state before the newest row, to redo it after a rewrite
+	double settledLoss{};
+
+	void Update(const DataStore& ds);
+};
+
+// Indicator results per symbol and parameter set, extended only by appended rows
+// and by the newest row again when UpdateLast rewrote it.
+class IndicatorCache
+{
+public:
+	// a compressed ds keeps what was computed before it was compressed
+	const IndicatorSeries& Get(SymbolID id, const DataStore& ds, IndicatorSpec spec);
+
+	// brings spec up to date for every symbol, split across worker threads,
+	// returns how many symbols were left as they were because their history is compressed
+	size_t UpdateAll(const MarketData& data, IndicatorSpec spec, unsigned numThreads = 0);
+
+	void Clear() { series.clear(); }
+
+private:
+	IndicatorSeries& Find(SymbolID id, IndicatorSpec spec);
+
+	std::vector<std::deque<IndicatorSeries>> series; // deque keeps returned references stable
+};
@@ -0,0 +1,304 @@
+#include "LoadGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+
+void LatencyHistogram::Add(uint64_t nanoseconds)
+{
+	size_t bucket = (size_t)nanoseconds;
+	if (nanoseconds >= SUB_BUCKETS)
+	{
+		// top three bits below the leading one pick the step within its power of two
+		const unsigned exponent = 63 - (unsigned)std::countl_zero(nanoseconds);
+		const size_t step = (size_t)(nanoseconds >> (exponent - 3)) & (SUB_BUCKETS - 1);
+		bucket = (exponent - 2) * SUB_BUCKETS + step;
+	}
+	++counts[bucket];
+	++total;
+	maximum = std::max(nanoseconds, maximum);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other)
+{
+	for (size_t i = 0; i < BUCKETS; ++i)
+		counts[i] += other.counts[i];
+	total += other.total;
+	maximum = std::max(other.maximum, maximum);
+}
+
+uint64_t LatencyHistogram::Percentile(double fraction) const
+{
+	if (total == 0)
+		return 0;
+
+	const uint64_t rank = (uint64_t)std::ceil(std::clamp(fraction, 0.0, 1.0) * total);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < BUCKETS; ++i)
+	{
+		seen += counts[i];
+		if (seen < std::max<uint64_t>(rank, 1))
+			continue;
+		if (i < SUB_BUCKETS)
+			return i;
+		const unsigned exponent = (unsigned)(i / SUB_BUCKETS) + 2;
+		const uint64_t upper = ((SUB_BUCKETS + i % SUB_BUCKETS + 1) << (exponent - 3)) - 1;
+		return std::min(upper, maximum);
+	}
+	return maximum;
+}
+
+namespace
+{
+	constexpr size_t MAX_LIVE_ORDERS = 1 << 16; // per producer and book, older ones are forgotten
+	constexpr double START_PRICE = 10000.0;
+
+	struct LiveOrder
+	{
+		OrderID id;
+		Side side;
+	};
+
+	// what the producers did during one sample
+	struct SampleCounts
+	{
+		LatencyHistogram latency;
+		uint64_t orders{};
+		uint64_t trades{};
+	};
+
+	struct Collector
+	{
+		std::mutex mutex;
+		std::condition_variable flushed;
+		std::vector<SampleCounts> samples;
+		std::vector<unsigned> flushes; // producers done with each sample
+	};
+
+	struct Producer
+	{
+		const LoadConfig& config;
+		std::vector<std::unique_ptr<OrderBook>>& books;
+		std::vector<std::atomic<double>>& mids;
+		Collector& collector;
+		std::chrono::steady_clock::time_point start;
+		unsigned index;
+
+		void Flush(size_t sample, const SampleCounts& counts)
+		{
+			std::lock_guard lock(collector.mutex);
+			SampleCounts& merged = collector.samples[sample];
+			merged.latency.Merge(counts.latency);
+			merged.orders += counts.orders;
+			merged.trades += counts.trades;
+			if (++collector.flushes[sample] == config.producers)
+				collector.flushed.notify_all();
+		}
+
+		double Walk(std::atomic<double>& mid, std::mt19937_64& rng, std::normal_distribution<double>& step) const
+		{
+			// producers race on the mid, a lost step only makes the walk a little calmer
+			double price = mid.load(std::memory_order_relaxed) + 0.5 * step(rng);
+			if (config.walk == PriceWalk::MeanReverting)
+				price += 0.01 * (START_PRICE - price);
+			else if (config.walk == PriceWalk::Jumpy && rng() % 1000 == 0)
+				price += 25.0 * step(rng);
+			price = std::max(price, 100.0);
+			mid.store(price, std::memory_order_relaxed);
+			return price;
+		}
+
+		void operator()()
+		{
+			std::mt19937_64 rng(config.seed * 7919 + index);
+			std::normal_distribution<double> step(0.0, 1.0);
+			std::exponential_distribution<double> gap(config.ordersPerSecond > 0.0 ? config.ordersPerSecond : 1.0);
+			std::discrete_distribution<int> action({ config.passive, config.aggressive, config.cancel, config.modify });
+			std::discrete_distribution<int> passiveType({ 0.6, 0.2, 0.2 });
+			std::discrete_distribution<int> aggressiveType({ 0.5, 0.3, 0.2 });
+			std::uniform_int_distribution<Quantity> size(1, 200);
+
+			std::vector<std::vector<LiveOrder>> live(books.size());
+			// ids stay unique across producers without any shared counter
+			OrderID nextID = (OrderID)index << 48;
+
+			const size_t sampleCount = collector.samples.size();
+			const auto duration = std::chrono::duration<double>(config.seconds);
+			auto arrival = start;
+			size_t sample = 0;
+			SampleCounts counts;
+
+			while (true)
+			{
+				if (config.ordersPerSecond > 0.0)
+				{
+					arrival += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(gap(rng)));
+					std::this_thread::sleep_until(arrival);
+				}
+
+				const auto sent = std::chrono::steady_clock::now();
+				if (sent - start >= duration)
+					break;
+				const size_t now = std::min((size_t)(std::chrono::duration<double>(sent - start).count() / config.sampleSeconds), sampleCount - 1);
+				for (; sample < now; ++sample)
+				{
+					Flush(sample, counts);
+					counts = SampleCounts{};
+				}
+
+				const size_t b = books.size() > 1 ? (size_t)(rng() % books.size()) : 0;
+				OrderBook& book = *books[b];
+				std::vector<LiveOrder>& orders = live[b];
+				const Price mid = (Price)Walk(mids[b], rng, step);
+				const Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+				const Price away = (Price)(1 + rng() % 20);
+				const Price through = (Price)(rng() % 10);
+
+				int what = action(rng);
+				if ((what == 2 || what == 3) && orders.empty())
+					what = 0;
+
+				Trades trades;
+				const auto called = std::chrono::steady_clock::now();
+				switch (what)
+				{
+				case 0:
+				{
+					const Price price = side == Side::Buy ? mid - away : mid + away;
+					const int type = passiveType(rng);
+					OrderRef order = type == 2
+						? book.CreateIceberg(++nextID, side, price, size(rng) * 10, size(rng))
+						: book.CreateOrder(type == 0 ? OrderType::GoodTillCancel : OrderType::GoodForDay, ++nextID, side, price, size(rng));
+					trades = book.AddOrder(order);
+					const LiveOrder entry{ nextID, side };
+					if (orders.size() < MAX_LIVE_ORDERS)
+						orders.push_back(entry);
+					else
+						orders[rng() % orders.size()] = entry;
+					break;
+				}
+				case 1:
+				{
+					constexpr OrderType types[] = { OrderType::FillAndKill, OrderType::FillOrKill, OrderType::Market };
+					const Price price = side == Side::Buy ? mid + through : mid - through;
+					trades = book.AddOrder(book.CreateOrder(types[aggressiveType(rng)], ++nextID, side, price, size(rng)));
+					break;
+				}
+				case 2:
+				{
+					const size_t at = (size_t)(rng() % orders.size());
+					book.CancelOrder(orders[at].id);
+					orders[at] = orders.back();
+					orders.pop_back();
+					break;
+				}
+				default:
+				{
+					// filled orders are still listed, modifying those is a cheap miss like it would be for a client
+					const LiveOrder& order = orders[rng() % orders.size()];
+					const Price price = order.side == Side::Buy ? mid - away : mid + away;
+					trades = book.ModifyOrder(OrderModify(order.id, order.side, price, size(rng)));
+					break;
+				}
+				}
+				const auto done = std::chrono::steady_clock::now();
+
+				counts.latency.Add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(done - called).count());
+				++counts.orders;
+				counts.trades += trades.size();
+			}
+
+			// samples the run ended in, and any after it if the clock overshot
+			for (; sample < sampleCount; ++sample)
+			{
+				Flush(sample, counts);
+				counts = SampleCounts{};
+			}
+		}
+	};
+}
+
+LoadReport RunLoad(const LoadConfig& config, const std::function<void(const LoadSample&)>& onSample)
+{
+	LoadConfig checked = config;
+	checked.producers = std::max(checked.producers, 1u);
+	checked.books = std::max(checked.books, 1u);
+	checked.sampleSeconds = std::max(checked.sampleSeconds, 0.01);
+	checked.seconds = std::max(checked.seconds, checked.sampleSeconds);
+
+	std::vector<std::unique_ptr<OrderBook>> books;
+	std::vector<std::atomic<double>> mids(checked.books);
+	for (unsigned b = 0; b < checked.books; ++b)
+	{
+		books.push_back(std::make_unique<OrderBook>(OrderBookMode::Shared, checked.allocator));
+		if (checked.reserveOrders)
+			books.back()->Reserve(checked.reserveOrders);
+		mids[b].store(START_PRICE);
+	}
+
+	Collector collector;
+	const size_t sampleCount = (size_t)std::ceil(checked.seconds / checked.sampleSeconds - 1e-9);
+	collector.samples.resize(sampleCount);
+	collector.flushes.resize(sampleCount);
+
+	LoadReport report;
+	const auto start = std::chrono::steady_clock::now();
+	{
+		std::vector<std::jthread> producers;
+		for (unsigned p = 0; p < checked.producers; ++p)
+			producers.emplace_back(Producer{ checked, books, mids, collector, start, p });
+
+		LockStats previous;
+		for (size_t i = 0; i < sampleCount; ++i)
+		{
+			SampleCounts counts;
+			{
+				std::unique_lock lock(collector.mutex);
+				collector.flushed.wait(lock, [&] { return collector.flushes[i] == checked.producers; });
+				counts = collector.samples[i];
+			}
+
+			LoadSample sample;
+			sample.seconds = std::min((i + 1) * checked.sampleSeconds, checked.seconds);
+			sample.orders = counts.orders;
+			sample.trades = counts.trades;
+			sample.ordersPerSecond = counts.orders / (sample.seconds - i * checked.sampleSeconds);
+			sample.p50 = counts.latency.Percentile(0.5);
+			sample.p99 = counts.latency.Percentile(0.99);
+			sample.p999 = counts.latency.Percentile(0.999);
+			sample.maximum = counts.latency.maximum;
+			sample.bookBytes = Memory::Stats(MemoryTag::OrderBook).liveBytes + Memory::Stats(MemoryTag::Orders).liveBytes;
+
+			LockStats lock;
+			for (const auto& book : books)
+			{
+				sample.restingOrders += book->Size();
+				const LockStats stats = book->LockContention();
+				lock.acquisitions += stats.acquisitions;
+				lock.contended += stats.contended;
+				lock.waitNanoseconds += stats.waitNanoseconds;
+			}
+			const uint64_t acquisitions = lock.acquisitions - previous.acquisitions;
+			const uint64_t contended = lock.contended - previous.contended;
+			sample.contendedShare = acquisitions ? (double)contended / acquisitions : 0.0;
+			sample.waitMicroseconds = contended ? (lock.waitNanoseconds - previous.waitNanoseconds) / 1000.0 / contended : 0.0;
+			previous = lock;
+
+			report.latency.Merge(counts.latency);
+			report.orders += counts.orders;
+			report.trades += counts.trades;
+			report.samples.push_back(sample);
+			if (onSample)
+				onSample(sample);
+		}
+		report.lock = previous;
+	}
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return report;
+}
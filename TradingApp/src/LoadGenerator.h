@@ -0,0 +1,80 @@
+#pragma once
+#include "Memory.h"
+#include "Orderbook.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+enum class PriceWalk
+{
+	Random,        // gaussian steps
+	MeanReverting, // gaussian steps pulled back towards the start price
+	Jumpy          // gaussian steps with rare jumps of many ticks
+};
+
+struct LoadConfig
+{
+	unsigned producers{ 4 };
+	unsigned books{ 1 };
+	double seconds{ 60.0 };
+	double ordersPerSecond{ 20000.0 }; // per producer, with exponential gaps between orders; 0 runs flat out
+	double sampleSeconds{ 1.0 };
+	PriceWalk walk{ PriceWalk::Random };
+	AllocatorKind allocator{ AllocatorKind::Pool };
+	size_t reserveOrders{};            // per book, sized before the producers start, 0 grows as it goes
+	uint64_t seed{ 42 };
+
+	// relative weights of what a producer does next
+	double passive{ 0.55 };    // GoodTillCancel, GoodForDay or Iceberg away from the mid
+	double aggressive{ 0.15 }; // FillAndKill, FillOrKill or Market through it
+	double cancel{ 0.20 };
+	double modify{ 0.10 };
+};
+
+// Log histogram of nanoseconds, SUB_BUCKETS linear steps per power of two,
+// so a percentile is within 1 / SUB_BUCKETS of the true value.
+struct LatencyHistogram
+{
+	static constexpr size_t SUB_BUCKETS = 8;
+	static constexpr size_t BUCKETS = 62 * SUB_BUCKETS;
+
+	uint64_t counts[BUCKETS]{};
+	uint64_t total{};
+	uint64_t maximum{};
+
+	void Add(uint64_t nanoseconds);
+	void Merge(const LatencyHistogram& other);
+	// upper edge of the bucket the fraction of samples falls into
+	uint64_t Percentile(double fraction) const;
+};
+
+struct LoadSample
+{
+	double seconds{};          // since the start, where the sample ends
+	uint64_t orders{};         // book calls made in the sample
+	uint64_t trades{};
+	double ordersPerSecond{};
+	uint64_t p50{};            // nanoseconds per book call
+	uint64_t p99{};
+	uint64_t p999{};
+	uint64_t maximum{};
+	uint64_t bookBytes{};      // order book and order memory live when the sample closed
+	uint64_t restingOrders{};  // over all books
+	double contendedShare{};   // lock acquisitions in the sample that had to wait
+	double waitMicroseconds{}; // average wait of those
+};
+
+struct LoadReport
+{
+	std::vector<LoadSample> samples;
+	LatencyHistogram latency;  // whole run
+	uint64_t orders{};
+	uint64_t trades{};
+	double seconds{};
+	LockStats lock;            // summed over books
+};
+
+// Soak test: producer threads send every OrderType, cancels and modifies into shared books at
+// Poisson arrival times for a fixed duration. Each sample reaches onSample, on the calling
+// thread, once every producer has moved past it, so long runs show degradation as it happens.
+LoadReport RunLoad(const LoadConfig& config, const std::function<void(const LoadSample&)>& onSample = {});
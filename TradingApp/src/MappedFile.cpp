@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX   /* don't define min() and max(). */
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		std::swap(data, other.data);
+		std::swap(size, other.size);
+#ifdef _WIN32
+		std::swap(fileHandle, other.fileHandle);
+		std::swap(mapHandle, other.mapHandle);
+#endif
+	}
+	return *this;
+}
+
+bool MappedFile::Open(const char* fileName, bool sequential)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize{};
+	if (GetFileSizeEx(file, &fileSize) == FALSE || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mapHandle = mapping;
+	data = static_cast<const char*>(view);
+	size = (size_t)fileSize.QuadPart;
+#else
+	int fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st {};
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // mapping keeps the file alive
+	if (view == MAP_FAILED)
+		return false;
+
+	if (sequential)
+		madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	data = static_cast<const char*>(view);
+	size = (size_t)st.st_size;
+#endif
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data == nullptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle((HANDLE)mapHandle);
+	CloseHandle((HANDLE)fileHandle);
+	mapHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	munmap(const_cast<char*>(data), size);
+#endif
+	data = nullptr;
+	size = 0;
+}
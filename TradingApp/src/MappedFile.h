@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	// sequential hints the OS to read ahead and drop pages behind, for one pass parsing
+	bool Open(const char* fileName, bool sequential = false);
+	void Close();
+
+	bool IsOpen() const { return data != nullptr; }
+	const char* Data() const { return data; }
+	size_t Size() const { return size; }
+
+private:
+	const char* data{ nullptr };
+	size_t size{};
+#ifdef _WIN32
+	void* fileHandle{ nullptr };
+	void* mapHandle{ nullptr };
+#endif
+};
@@ -0,0 +1,185 @@
+#include "MarketCache.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+	constexpr char CACHE_MAGIC[8] = { 'T','A','C','A','C','H','E','\0' };
+	constexpr uint32_t CACHE_VERSION = 1;
+	constexpr uint32_t CACHE_COLUMNS = 6;
+	constexpr uint64_t CACHE_ALIGN = 64;
+
+	struct CacheHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t symbolCount;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		uint64_t totalRows;
+		uint64_t namesOffset;
+		uint64_t columnsOffset;
+	};
+
+	struct CacheSymbol
+	{
+		uint64_t rowOffset;
+		uint64_t rowCount;
+		double minimum;
+		double maximum;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+	};
+
+	bool SourceStamp(const char* sourceName, uint64_t& outSize, int64_t& outTime)
+	{
+		std::error_code ec;
+		outSize = std::filesystem::file_size(sourceName, ec);
+		if (ec)
+			return false;
+		outTime = (int64_t)std::filesystem::last_write_time(sourceName, ec).time_since_epoch().count();
+		return !ec;
+	}
+
+	uint64_t AlignUp(uint64_t value)
+	{
+		return (value + CACHE_ALIGN - 1) & ~(CACHE_ALIGN - 1);
+	}
+
+	const Column& GetColumn(const DataStore& ds, uint32_t index)
+	{
+		const Column* columns[CACHE_COLUMNS] = { &ds.date, &ds.open, &ds.high, &ds.low, &ds.close, &ds.volume };
+		return *columns[index];
+	}
+
+	Column& GetColumn(DataStore& ds, uint32_t index)
+	{
+		return const_cast<Column&>(GetColumn(static_cast<const DataStore&>(ds), index));
+	}
+}
+
+bool WriteMarketCache(const char* cacheName, const char* sourceName, const MarketData& data)
+{
+	CacheHeader header{};
+	std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.symbolCount = (uint32_t)data.Count();
+	if (SourceStamp(sourceName, header.sourceSize, header.sourceTime) == false)
+		return false;
+
+	std::vector<CacheSymbol> symbols;
+	std::string names;
+	symbols.reserve(data.Count());
+	for (const DataStore& ds : data.Stores())
+	{
+		const std::string& name = ds.name;
+		CacheSymbol symbol{};
+		symbol.rowOffset = header.totalRows;
+		symbol.rowCount = ds.size();
+		symbol.minimum = ds.minimum;
+		symbol.maximum = ds.maximum;
+		symbol.nameOffset = (uint32_t)names.size();
+		symbol.nameLength = (uint32_t)name.size();
+		symbols.push_back(symbol);
+
+		names += name;
+		header.totalRows += ds.size();
+	}
+
+	header.namesOffset = sizeof(CacheHeader) + symbols.size() * sizeof(CacheSymbol);
+	header.columnsOffset = AlignUp(header.namesOffset + names.size());
+
+	// write next to the target and rename so a crash never leaves half a cache behind
+	std::string tempName = std::string(cacheName) + ".tmp";
+	{
+		std::ofstream out(tempName, std::ios::binary | std::ios::trunc);
+		if (!out)
+			return false;
+
+		out.write((const char*)&header, sizeof(header));
+		out.write((const char*)symbols.data(), symbols.size() * sizeof(CacheSymbol));
+		out.write(names.data(), names.size());
+
+		const char padding[CACHE_ALIGN] = {};
+		out.write(padding, header.columnsOffset - (header.namesOffset + names.size()));
+
+		for (uint32_t c = 0; c < CACHE_COLUMNS; ++c)
+		{
+			for (const DataStore& ds : data.Stores())
+			{
+				const Column& column = GetColumn(ds, c);
+				out.write((const char*)column.data(), column.size() * sizeof(double));
+			}
+		}
+
+		if (!out)
+			return false;
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tempName, cacheName, ec);
+	return !ec;
+}
+
+bool LoadMarketCache(const char* cacheName, const char* sourceName, MappedFile& outFile, MarketData& outData)
+{
+	uint64_t sourceSize{};
+	int64_t sourceTime{};
+	if (SourceStamp(sourceName, sourceSize, sourceTime) == false)
+		return false;
+
+	MappedFile file;
+	if (file.Open(cacheName) == false || file.Size() < sizeof(CacheHeader))
+		return false;
+
+	CacheHeader header;
+	std::memcpy(&header, file.Data(), sizeof(header));
+	if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+		|| header.version != CACHE_VERSION
+		|| header.sourceSize != sourceSize
+		|| header.sourceTime != sourceTime)
+		return false;
+
+	// a stamp that matches says nothing about the rest of the file, check every offset
+	// before anything is read through it, so a damaged cache falls back to the csv
+	const uint64_t fileSize = file.Size();
+	const uint64_t symbolsEnd = sizeof(CacheHeader) + (uint64_t)header.symbolCount * sizeof(CacheSymbol);
+	if (header.namesOffset < symbolsEnd
+		|| header.columnsOffset < header.namesOffset
+		|| header.columnsOffset % CACHE_ALIGN != 0
+		|| header.columnsOffset > fileSize
+		|| header.totalRows > (fileSize - header.columnsOffset) / (CACHE_COLUMNS * sizeof(double)))
+		return false;
+
+	const CacheSymbol* symbols = (const CacheSymbol*)(file.Data() + sizeof(CacheHeader));
+	const char* names = file.Data() + header.namesOffset;
+	const double* columns = (const double*)(file.Data() + header.columnsOffset);
+
+	const uint64_t namesSize = header.columnsOffset - header.namesOffset;
+	for (uint32_t i = 0; i < header.symbolCount; ++i)
+	{
+		const CacheSymbol& symbol = symbols[i];
+		if ((uint64_t)symbol.nameOffset + symbol.nameLength > namesSize
+			|| symbol.rowOffset > header.totalRows
+			|| symbol.rowCount > header.totalRows - symbol.rowOffset)
+			return false;
+	}
+
+	for (uint32_t i = 0; i < header.symbolCount; ++i)
+	{
+		const CacheSymbol& symbol = symbols[i];
+		DataStore& ds = outData.Get(outData.Intern(std::string_view(names + symbol.nameOffset, symbol.nameLength)));
+		ds.minimum = symbol.minimum;
+		ds.maximum = symbol.maximum;
+		for (uint32_t c = 0; c < CACHE_COLUMNS; ++c)
+		{
+			GetColumn(ds, c).View(columns + c * header.totalRows + symbol.rowOffset, symbol.rowCount);
+		}
+	}
+
+	outFile = std::move(file);
+	return true;
+}
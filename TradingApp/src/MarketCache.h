@@ -0,0 +1,16 @@
+#pragma once
+#include "MappedFile.h"
+#include "MarketData.h"
+
+// Columnar binary cache of a parsed market CSV.
+// Layout: header, symbol table, symbol names, then date/open/high/low/close/volume
+// columns each holding every row back to back, grouped by symbol.
+// The cache remembers the size and write time of the CSV it was built from.
+
+// Writes data to cacheName, tagged with the current size/mtime of sourceName.
+bool WriteMarketCache(const char* cacheName, const char* sourceName, const MarketData& data);
+
+// Maps cacheName if it matches sourceName and interns its symbols into outData, in cache order,
+// with columns viewing the mapping.
+// outFile must outlive outData.
+bool LoadMarketCache(const char* cacheName, const char* sourceName, MappedFile& outFile, MarketData& outData);
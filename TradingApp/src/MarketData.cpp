@@ -0,0 +1,139 @@
+#include "MarketData.h"
+#include "CompressedColumn.h"
+#include <algorithm>
+#include <numeric>
+
+void MarketData::Allocate(std::vector<std::string> symbolNames, const std::vector<size_t>& rowCounts)
+{
+	Clear();
+
+	const size_t totalRows = std::accumulate(rowCounts.begin(), rowCounts.end(), size_t{});
+	arena.resize(totalRows * NUM_COLUMNS);
+	arenaOffsets.resize(symbolNames.size());
+	arenaRows.assign(rowCounts.begin(), rowCounts.end());
+	stores.resize(symbolNames.size());
+	levels.resize(symbolNames.size());
+
+	size_t offset = 0;
+	for (SymbolID id = 0; id < (SymbolID)symbolNames.size(); ++id)
+	{
+		const size_t rows = rowCounts[id];
+		DataStore& ds = stores[id];
+		ds.name = std::move(symbolNames[id]);
+		ids.emplace(ds.name, id);
+		arenaOffsets[id] = offset;
+
+		double* columns[NUM_COLUMNS];
+		ArenaColumns(id, columns);
+		ds.date.View(columns[0], rows);
+		ds.open.View(columns[1], rows);
+		ds.high.View(columns[2], rows);
+		ds.low.View(columns[3], rows);
+		ds.close.View(columns[4], rows);
+		ds.volume.View(columns[5], rows);
+
+		offset += rows * NUM_COLUMNS;
+	}
+
+	RebuildNames();
+}
+
+void MarketData::ArenaColumns(SymbolID id, double* outColumns[NUM_COLUMNS])
+{
+	const size_t rows = arenaRows[id];
+	double* base = arena.data() + arenaOffsets[id];
+	for (size_t c = 0; c < NUM_COLUMNS; ++c)
+	{
+		outColumns[c] = base + c * rows;
+	}
+}
+
+SymbolID MarketData::Intern(std::string_view name)
+{
+	SymbolID id = Find(name);
+	if (id != INVALID_SYMBOL)
+		return id;
+
+	id = (SymbolID)stores.size();
+	stores.emplace_back().name = std::string(name);
+	ids.emplace(stores.back().name, id);
+	arenaOffsets.push_back(0);
+	arenaRows.push_back(0);
+	levels.emplace_back();
+	RebuildNames();
+	return id;
+}
+
+const DataStore& MarketData::Resampled(SymbolID id, ResampleSpec spec)
+{
+	auto& symbolLevels = levels[id];
+	auto it = std::find_if(symbolLevels.begin(), symbolLevels.end(),
+		[&spec](const ResampledLevel& level) { return level.Spec() == spec; });
+	ResampledLevel& level = it != symbolLevels.end() ? *it : symbolLevels.emplace_back(spec);
+
+	level.Update(stores[id]);
+	return level.Bars();
+}
+
+SymbolID MarketData::Find(std::string_view name) const
+{
+	auto it = ids.find(name);
+	return it != ids.end() ? it->second : INVALID_SYMBOL;
+}
+
+void MarketData::Clear()
+{
+	stores.clear();
+	names.clear();
+	ids.clear();
+	arena.clear();
+	arena.shrink_to_fit();
+	arenaOffsets.clear();
+	arenaRows.clear();
+	levels.clear();
+}
+
+void MarketData::Compress()
+{
+	for (DataStore& ds : stores)
+	{
+		ds.Compress();
+	}
+
+	// no column views the arena anymore
+	arena.clear();
+	arena.shrink_to_fit();
+	std::fill(arenaRows.begin(), arenaRows.end(), 0);
+}
+
+void MarketData::Decompress()
+{
+	for (DataStore& ds : stores)
+	{
+		ds.Decompress();
+	}
+}
+
+void MarketData::CompressedSize(size_t& outPacked, size_t& outRaw) const
+{
+	outPacked = 0;
+	outRaw = 0;
+	for (const DataStore& ds : stores)
+	{
+		if (ds.packed)
+		{
+			outPacked += ds.packed->Bytes();
+			outRaw += ds.packed->size() * NUM_COLUMNS * sizeof(double);
+		}
+	}
+}
+
+void MarketData::RebuildNames()
+{
+	// moving a DataStore can move its name's characters (small string buffer)
+	names.resize(stores.size());
+	for (size_t i = 0; i < stores.size(); ++i)
+	{
+		names[i] = stores[i].name.c_str();
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "DataStore.h"
+#include "Resampler.h"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using SymbolID = uint32_t;
+constexpr SymbolID INVALID_SYMBOL = UINT32_MAX;
+
+// Every loaded symbol, interned to a dense SymbolID.
+// Bulk loads place all columns of all symbols in a single arena, each symbol's six columns
+// back to back, so a symbol's history is one contiguous block.
+class MarketData
+{
+public:
+	static constexpr size_t NUM_COLUMNS = 6;
+
+	// Interns names in the given order and carves one arena slice per symbol.
+	// Columns of the returned stores view the arena, fill them through ArenaColumns.
+	void Allocate(std::vector<std::string> symbolNames, const std::vector<size_t>& rowCounts);
+
+	// date/open/high/low/close/volume slices for a symbol laid out by Allocate
+	void ArenaColumns(SymbolID id, double* outColumns[NUM_COLUMNS]);
+
+	// Adds a symbol outside the arena, returns the existing ID if already known
+	SymbolID Intern(std::string_view name);
+	SymbolID Find(std::string_view name) const;
+
+	DataStore& Get(SymbolID id) { return stores[id]; }
+	const DataStore& Get(SymbolID id) const { return stores[id]; }
+
+	// coarser bars for a symbol, built in one pass on first use and afterwards
+	// only extended by the rows appended since the previous call
+	const DataStore& Resampled(SymbolID id, ResampleSpec spec);
+
+	size_t Count() const { return stores.size(); }
+	bool Empty() const { return stores.empty(); }
+
+	// names indexed by SymbolID, for list widgets
+	const char* const* Names() const { return names.data(); }
+
+	std::vector<DataStore>& Stores() { return stores; }
+	const std::vector<DataStore>& Stores() const { return stores; }
+
+	void Clear();
+
+	// Compresses every symbol's history and frees the bulk load arena, decompressing
+	// brings the columns back as owned vectors. Nothing may read the stores meanwhile,
+	// and copies of stores that viewed the arena are left dangling.
+	void Compress();
+	void Decompress();
+	// compressed bytes and the bytes the same rows take as plain columns
+	void CompressedSize(size_t& outPacked, size_t& outRaw) const;
+
+private:
+	struct NameHash
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+	};
+
+	void RebuildNames();
+
+	std::vector<DataStore> stores;
+	std::vector<const char*> names;
+	std::unordered_map<std::string, SymbolID, NameHash, std::equal_to<>> ids;
+
+	std::vector<std::deque<ResampledLevel>> levels; // deque keeps returned references stable
+
+	std::pmr::vector<double> arena{ Memory::Tracked(MemoryTag::MarketData) };
+	std::vector<size_t> arenaOffsets;
+	std::vector<size_t> arenaRows;
+};
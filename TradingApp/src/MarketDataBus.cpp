@@ -0,0 +1,289 @@
+#include "MarketDataBus.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX   /* don't define min() and max(). */
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct BusSlot
+{
+	// sequence + 1 once the message is complete, 0 while the writer is copying into it
+	std::atomic<uint64_t> stamp;
+	BusMessage msg;
+};
+
+struct BusLayout
+{
+	uint32_t magic;
+	uint32_t version;
+	std::atomic<uint64_t> writeSequence;
+
+	// seqlock, odd while the writer is updating the snapshot
+	std::atomic<uint64_t> snapshotStamp;
+	BusMessage snapshot;
+
+	BusSlot slots[BUS_RING_CAPACITY];
+};
+
+namespace
+{
+	constexpr uint64_t RING_MASK = BUS_RING_CAPACITY - 1;
+	constexpr int SNAPSHOT_RETRIES = 64;
+
+	std::string ShmName(const char* name)
+	{
+#ifdef _WIN32
+		return std::string("Local\\") + name;
+#else
+		return std::string("/") + name;
+#endif
+	}
+
+	void* MapShared(const std::string& name, size_t size, bool create, void*& outHandle)
+	{
+#ifdef _WIN32
+		HANDLE mapping = create
+			? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+				(DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), name.c_str())
+			: OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+		if (mapping == nullptr)
+			return nullptr;
+
+		void* view = MapViewOfFile(mapping, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, size);
+		if (view == nullptr)
+		{
+			CloseHandle(mapping);
+			return nullptr;
+		}
+		outHandle = mapping;
+		return view;
+#else
+		(void)outHandle;
+		int fd = create
+			? shm_open(name.c_str(), O_CREAT | O_RDWR, 0666)
+			: shm_open(name.c_str(), O_RDONLY, 0);
+		if (fd < 0)
+			return nullptr;
+
+		if (create && ftruncate(fd, (off_t)size) != 0)
+		{
+			close(fd);
+			return nullptr;
+		}
+
+		struct stat st {};
+		if (fstat(fd, &st) != 0 || (size_t)st.st_size < size)
+		{
+			close(fd);
+			return nullptr;
+		}
+
+		void* view = mmap(nullptr, size, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+		close(fd); // mapping keeps the object alive
+		return view == MAP_FAILED ? nullptr : view;
+#endif
+	}
+
+	void UnmapShared(const void* view, size_t size, void* handle)
+	{
+#ifdef _WIN32
+		(void)size;
+		UnmapViewOfFile(view);
+		CloseHandle((HANDLE)handle);
+#else
+		(void)handle;
+		munmap(const_cast<void*>(view), size);
+#endif
+	}
+}
+
+MarketDataPublisher::MarketDataPublisher(const char* _name)
+	: name{ ShmName(_name) }
+{
+	void* view = MapShared(name, sizeof(BusLayout), true, handle);
+	if (view == nullptr)
+	{
+		printf("Cannot create market data bus %s\n", name.c_str());
+		return;
+	}
+
+	layout = new (view) BusLayout{};
+	layout->version = BUS_VERSION;
+	layout->writeSequence.store(0, std::memory_order_relaxed);
+	layout->snapshotStamp.store(0, std::memory_order_relaxed);
+	for (BusSlot& slot : layout->slots)
+	{
+		slot.stamp.store(0, std::memory_order_relaxed);
+	}
+	// readers refuse to attach until the magic is visible
+	std::atomic_thread_fence(std::memory_order_release);
+	layout->magic = BUS_MAGIC;
+}
+
+MarketDataPublisher::~MarketDataPublisher()
+{
+	if (layout == nullptr)
+		return;
+
+	layout->magic = 0;
+	UnmapShared(layout, sizeof(BusLayout), handle);
+#ifndef _WIN32
+	shm_unlink(name.c_str());
+#endif
+}
+
+void MarketDataPublisher::PublishTrades(const Trades& trades, Side aggressor)
+{
+	if (layout == nullptr || trades.empty())
+		return;
+
+	BusMessage msg;
+	msg.type = BusMessage::Type::Trade;
+	msg.trade.aggressor = aggressor;
+	msg.trade.time = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	for (const Trade& trade : trades)
+	{
+		msg.trade.bidID = trade.bidTrade.orderID;
+		msg.trade.askID = trade.askTrade.orderID;
+		msg.trade.bidPrice = trade.bidTrade.price;
+		msg.trade.askPrice = trade.askTrade.price;
+		msg.trade.quantity = trade.bidTrade.quantity;
+		Publish(msg);
+	}
+}
+
+void MarketDataPublisher::PublishDepth(const OrderBookLevelInfos& levels)
+{
+	if (layout == nullptr)
+		return;
+
+	BusMessage msg;
+	msg.type = BusMessage::Type::Depth;
+	msg.depth = BusDepth{};
+	msg.depth.numBids = (uint32_t)std::min(levels.bids.size(), BUS_DEPTH_LEVELS);
+	msg.depth.numAsks = (uint32_t)std::min(levels.asks.size(), BUS_DEPTH_LEVELS);
+	std::copy_n(levels.bids.begin(), msg.depth.numBids, msg.depth.bids);
+	std::copy_n(levels.asks.begin(), msg.depth.numAsks, msg.depth.asks);
+	Publish(msg);
+
+	// keep the latest snapshot outside the ring so overrun readers can resync
+	const uint64_t stamp = layout->snapshotStamp.load(std::memory_order_relaxed);
+	layout->snapshotStamp.store(stamp + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(&layout->snapshot, &msg, sizeof(BusMessage));
+	layout->snapshotStamp.store(stamp + 2, std::memory_order_release);
+}
+
+uint64_t MarketDataPublisher::Sequence() const
+{
+	return layout ? layout->writeSequence.load(std::memory_order_relaxed) : 0;
+}
+
+void MarketDataPublisher::Publish(BusMessage& msg)
+{
+	const uint64_t sequence = layout->writeSequence.load(std::memory_order_relaxed);
+	msg.sequence = sequence;
+
+	BusSlot& slot = layout->slots[sequence & RING_MASK];
+	slot.stamp.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(&slot.msg, &msg, sizeof(BusMessage));
+	slot.stamp.store(sequence + 1, std::memory_order_release);
+
+	layout->writeSequence.store(sequence + 1, std::memory_order_release);
+}
+
+MarketDataSubscriber::MarketDataSubscriber(const char* _name)
+{
+	const void* view = MapShared(ShmName(_name), sizeof(BusLayout), false, handle);
+	if (view == nullptr)
+		return;
+
+	const BusLayout* mapped = static_cast<const BusLayout*>(view);
+	if (mapped->magic != BUS_MAGIC || mapped->version != BUS_VERSION)
+	{
+		printf("Market data bus %s is not ready\n", _name);
+		UnmapShared(view, sizeof(BusLayout), handle);
+		return;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	layout = mapped;
+}
+
+MarketDataSubscriber::~MarketDataSubscriber()
+{
+	if (layout)
+	{
+		UnmapShared(layout, sizeof(BusLayout), handle);
+	}
+}
+
+MarketDataSubscriber::Result MarketDataSubscriber::Poll(BusMessage& outMsg)
+{
+	if (layout == nullptr)
+		return Result::Closed;
+
+	const uint64_t written = layout->writeSequence.load(std::memory_order_acquire);
+	if (nextSequence >= written)
+		return Result::Empty;
+
+	// writer has lapped us, the slot we want is gone
+	if (written - nextSequence > BUS_RING_CAPACITY)
+		return ReadSnapshot(outMsg) ? Result::Resynced : Result::Empty;
+
+	const BusSlot& slot = layout->slots[nextSequence & RING_MASK];
+	const uint64_t before = slot.stamp.load(std::memory_order_acquire);
+	if (before != nextSequence + 1)
+		return ReadSnapshot(outMsg) ? Result::Resynced : Result::Empty;
+
+	std::memcpy(&outMsg, &slot.msg, sizeof(BusMessage));
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	// slot was overwritten while we copied
+	if (slot.stamp.load(std::memory_order_relaxed) != before)
+		return ReadSnapshot(outMsg) ? Result::Resynced : Result::Empty;
+
+	++nextSequence;
+	return Result::Message;
+}
+
+bool MarketDataSubscriber::ReadSnapshot(BusMessage& outMsg)
+{
+	++overruns;
+
+	for (int i = 0; i < SNAPSHOT_RETRIES; ++i)
+	{
+		const uint64_t before = layout->snapshotStamp.load(std::memory_order_acquire);
+		if (before == 0)
+			break; // nothing published yet
+		if (before & 1)
+			continue; // writer is mid update
+
+		std::memcpy(&outMsg, &layout->snapshot, sizeof(BusMessage));
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (layout->snapshotStamp.load(std::memory_order_relaxed) == before)
+		{
+			nextSequence = outMsg.sequence + 1;
+			return true;
+		}
+	}
+
+	// no consistent snapshot, skip to the live edge
+	nextSequence = layout->writeSequence.load(std::memory_order_acquire);
+	return false;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "Orderbook.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Shared memory market data bus.
+// One engine process publishes trades and depth snapshots into a fixed size ring,
+// any number of read-only processes follow it without ever blocking the writer.
+
+constexpr const char* BUS_DEFAULT_NAME = "tradingapp_md";
+constexpr uint32_t BUS_MAGIC = 0x5442444D; // "MDBT"
+constexpr uint32_t BUS_VERSION = 2;
+constexpr size_t BUS_DEPTH_LEVELS = 32;
+constexpr size_t BUS_RING_CAPACITY = 4096; // must be power of two
+
+static_assert((BUS_RING_CAPACITY & (BUS_RING_CAPACITY - 1)) == 0, "ring capacity must be power of two");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "bus requires lock free 64bit atomics");
+
+struct BusTrade
+{
+	OrderID bidID{};
+	OrderID askID{};
+	Price bidPrice{};
+	Price askPrice{};
+	Quantity quantity{};
+	Side aggressor{};   // side of the incoming order
+	uint64_t time{};    // nanoseconds since the unix epoch, when the engine matched it
+};
+
+struct BusDepth
+{
+	uint32_t numBids{};
+	uint32_t numAsks{};
+	LevelInfo bids[BUS_DEPTH_LEVELS]{};
+	LevelInfo asks[BUS_DEPTH_LEVELS]{};
+};
+
+struct BusMessage
+{
+	enum class Type : uint32_t
+	{
+		Trade,
+		Depth
+	};
+
+	uint64_t sequence{};
+	Type type{};
+	union
+	{
+		BusTrade trade;
+		BusDepth depth;
+	};
+
+	BusMessage() : trade{} {}
+};
+
+class MarketDataPublisher
+{
+public:
+	MarketDataPublisher(const char* _name);
+	~MarketDataPublisher();
+
+	MarketDataPublisher(const MarketDataPublisher&) = delete;
+	MarketDataPublisher& operator=(const MarketDataPublisher&) = delete;
+
+	bool IsOpen() const { return layout != nullptr; }
+
+	// trades of one incoming order on the given side
+	void PublishTrades(const Trades& trades, Side aggressor);
+	void PublishDepth(const OrderBookLevelInfos& levels);
+
+	uint64_t Sequence() const;
+
+private:
+	void Publish(BusMessage& msg);
+
+	struct BusLayout* layout{ nullptr };
+	std::string name;
+	void* handle{ nullptr };
+};
+
+class MarketDataSubscriber
+{
+public:
+	enum class Result
+	{
+		Message,   // outMsg holds the next message in sequence
+		Empty,     // writer has not published anything new
+		Resynced,  // reader was overrun, outMsg holds the latest depth snapshot
+		Closed     // bus is not mapped
+	};
+
+	MarketDataSubscriber(const char* _name);
+	~MarketDataSubscriber();
+
+	MarketDataSubscriber(const MarketDataSubscriber&) = delete;
+	MarketDataSubscriber& operator=(const MarketDataSubscriber&) = delete;
+
+	bool IsOpen() const { return layout != nullptr; }
+
+	Result Poll(BusMessage& outMsg);
+
+	uint64_t Overruns() const { return overruns; }
+	uint64_t NextSequence() const { return nextSequence; }
+
+private:
+	bool ReadSnapshot(BusMessage& outMsg);
+
+	const struct BusLayout* layout{ nullptr };
+	void* handle{ nullptr };
+	uint64_t nextSequence{};
+	uint64_t overruns{};
+};
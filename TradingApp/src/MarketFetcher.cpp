@@ -0,0 +1,260 @@
+#include "MarketFetcher.h"
+#include "CsvLoader.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <curl/curl.h>
+
+namespace
+{
+	// simultaneous connections per host, more transfers to the same host queue for a free one
+	constexpr long MAX_HOST_CONNECTIONS = 16;
+	constexpr long CONNECT_TIMEOUT_MS = 5000;
+	// upper bound for one curl_multi_poll, new requests wake it earlier
+	constexpr int POLL_MS = 1000;
+
+	std::once_flag curlInit;
+}
+
+struct MarketFetcher::Transfer
+{
+	CURL* easy{ nullptr };
+	bool skipHeader{ true };
+	std::string carry; // the unfinished last line of the previous read
+	char error[CURL_ERROR_SIZE]{};
+	FetchResult result;
+
+	void ParseLines(const char* cursor, const char* end)
+	{
+		if (skipHeader && cursor < end)
+		{
+			cursor = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor)) + 1;
+			skipHeader = false;
+		}
+
+		while (cursor < end)
+		{
+			DataFrame df{};
+			std::string_view name;
+			if (ParseCsvRow(cursor, end, df, name) == false)
+				continue;
+
+			std::vector<DataStore>& stores = result.stores;
+			if (stores.empty() || stores.back().name != name)
+			{
+				stores.emplace_back();
+				stores.back().name = name;
+			}
+			stores.back().PushData(df);
+		}
+	}
+
+	// complete lines are parsed straight out of curl's buffer, only the tail is kept
+	size_t Write(const char* data, size_t size)
+	{
+		PROFILE_SCOPE("MarketFetcher::Write");
+		result.bytes += size;
+		const char* cursor = data;
+		const char* end = data + size;
+
+		if (carry.empty() == false)
+		{
+			const char* eol = static_cast<const char*>(std::memchr(cursor, '\n', size));
+			if (eol == nullptr)
+			{
+				carry.append(data, size);
+				return size;
+			}
+			carry.append(cursor, eol + 1);
+			ParseLines(carry.data(), carry.data() + carry.size());
+			carry.clear();
+			cursor = eol + 1;
+		}
+
+		const char* complete = end;
+		while (complete > cursor && complete[-1] != '\n')
+		{
+			--complete;
+		}
+		ParseLines(cursor, complete);
+		carry.assign(complete, end);
+		return size;
+	}
+
+	// a body that does not end with a newline still has its last row
+	void Flush()
+	{
+		if (carry.empty() == false)
+		{
+			carry.push_back('\n');
+			ParseLines(carry.data(), carry.data() + carry.size());
+			carry.clear();
+		}
+	}
+
+	static size_t OnWrite(char* data, size_t size, size_t count, void* user)
+	{
+		return static_cast<Transfer*>(user)->Write(data, size * count);
+	}
+};
+
+MarketFetcher::MarketFetcher()
+{
+	// curl_global_init is not thread safe, the first fetcher does it before any thread uses curl
+	std::call_once(curlInit, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+	multi = curl_multi_init();
+	curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, MAX_HOST_CONNECTIONS);
+	// HTTP/2 servers get every request multiplexed over one connection
+	curl_multi_setopt(multi, CURLMOPT_PIPELINING, (long)CURLPIPE_MULTIPLEX);
+
+	thread = std::jthread([this](std::stop_token stop) { Loop(stop); });
+}
+
+MarketFetcher::~MarketFetcher()
+{
+	thread.request_stop();
+	curl_multi_wakeup(multi);
+	thread.join();
+
+	for (void* easy : idleHandles)
+	{
+		curl_easy_cleanup(easy);
+	}
+	curl_multi_cleanup(multi);
+}
+
+void MarketFetcher::Fetch(std::string url, bool skipHeader)
+{
+	auto transfer = std::make_unique<Transfer>();
+	transfer->result.url = std::move(url);
+	transfer->skipHeader = skipHeader;
+	++pending;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued.push_back(std::move(transfer));
+	}
+	curl_multi_wakeup(multi);
+}
+
+size_t MarketFetcher::Drain(std::vector<FetchResult>& outResults)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const size_t count = finished.size();
+	outResults.insert(outResults.end(), std::make_move_iterator(finished.begin()), std::make_move_iterator(finished.end()));
+	finished.clear();
+	return count;
+}
+
+void MarketFetcher::Loop(std::stop_token stop)
+{
+	PROFILE_THREAD("Fetcher");
+	while (stop.stop_requested() == false)
+	{
+		StartQueued();
+
+		int running = 0;
+		curl_multi_perform(multi, &running);
+		FinishDone();
+
+		curl_multi_poll(multi, nullptr, 0, POLL_MS, nullptr);
+	}
+
+	// whatever is still in flight is dropped
+	for (std::unique_ptr<Transfer>& transfer : active)
+	{
+		curl_multi_remove_handle(multi, transfer->easy);
+		idleHandles.push_back(transfer->easy);
+	}
+	active.clear();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	queued.clear();
+}
+
+void MarketFetcher::StartQueued()
+{
+	std::deque<std::unique_ptr<Transfer>> starting;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		starting.swap(queued);
+	}
+
+	for (std::unique_ptr<Transfer>& transfer : starting)
+	{
+		// a reused handle keeps its connection and resolved names, only per request options change
+		CURL* easy;
+		if (idleHandles.empty())
+		{
+			easy = curl_easy_init();
+			curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, &Transfer::OnWrite);
+			curl_easy_setopt(easy, CURLOPT_FAILONERROR, 1L);
+			curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+			curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+			curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, CONNECT_TIMEOUT_MS);
+			// wait for a multiplexed connection rather than open another one
+			curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+		}
+		else
+		{
+			easy = idleHandles.back();
+			idleHandles.pop_back();
+		}
+
+		Transfer* raw = transfer.get();
+		raw->easy = easy;
+		curl_easy_setopt(easy, CURLOPT_URL, raw->result.url.c_str());
+		curl_easy_setopt(easy, CURLOPT_WRITEDATA, raw);
+		curl_easy_setopt(easy, CURLOPT_PRIVATE, raw);
+		curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, raw->error);
+		curl_multi_add_handle(multi, easy);
+		active.push_back(std::move(transfer));
+	}
+}
+
+void MarketFetcher::FinishDone()
+{
+	bool any = false;
+	CURLMsg* message;
+	int left;
+	while ((message = curl_multi_info_read(multi, &left)) != nullptr)
+	{
+		if (message->msg != CURLMSG_DONE)
+			continue;
+
+		CURL* easy = message->easy_handle;
+		Transfer* raw = nullptr;
+		curl_easy_getinfo(easy, CURLINFO_PRIVATE, &raw);
+		auto found = std::find_if(active.begin(), active.end(), [raw](const std::unique_ptr<Transfer>& t) { return t.get() == raw; });
+		std::unique_ptr<Transfer> transfer = std::move(*found);
+		*found = std::move(active.back());
+		active.pop_back();
+
+		FetchResult& result = transfer->result;
+		result.ok = message->data.result == CURLE_OK;
+		if (result.ok)
+		{
+			transfer->Flush();
+		}
+		else
+		{
+			// a cut off body is not worth keeping
+			result.stores.clear();
+			result.error = transfer->error[0] != '\0' ? transfer->error : curl_easy_strerror(message->data.result);
+		}
+
+		curl_multi_remove_handle(multi, easy);
+		curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, (char*)nullptr);
+		idleHandles.push_back(easy);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finished.push_back(std::move(result));
+		}
+		--pending;
+		any = true;
+	}
+
+	if (any && onResult)
+		onResult();
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "DataStore.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FetchResult
+{
+	std::string url;
+	bool ok{ false };
+	std::string error;
+	std::vector<DataStore> stores; // one per run of rows sharing a name, in response order
+	uint64_t bytes{};
+};
+
+// Downloads market CSV over http(s) or file:// URLs on its own curl_multi event loop thread.
+// Every request becomes a transfer on one shared multi handle, so many symbols are in flight
+// at once and connections to the same host are kept alive and reused across requests.
+// Response bodies are parsed as they arrive with the same row parser as local files; only a
+// line split across two network reads is ever copied.
+class MarketFetcher
+{
+public:
+	MarketFetcher();
+	~MarketFetcher();
+
+	MarketFetcher(const MarketFetcher&) = delete;
+	MarketFetcher& operator=(const MarketFetcher&) = delete;
+
+	// onResult runs on the fetcher thread after finished transfers were queued, set it before the first Fetch
+	void SetOnResult(std::function<void()> _onResult) { onResult = std::move(_onResult); }
+
+	// queues a download, the first line of the body is skipped as a header when skipHeader
+	void Fetch(std::string url, bool skipHeader = true);
+
+	// moves every finished transfer since the previous call into outResults, returns how many
+	size_t Drain(std::vector<FetchResult>& outResults);
+
+	// transfers queued or in flight
+	size_t Pending() const { return pending; }
+
+private:
+	struct Transfer;
+
+	void Loop(std::stop_token stop);
+	void StartQueued();
+	void FinishDone();
+
+	void* multi{ nullptr }; // CURLM, kept opaque so curl stays out of this header
+	// only touched by the fetcher thread
+	std::vector<std::unique_ptr<Transfer>> active;
+	std::vector<void*> idleHandles; // finished easy handles, reused for the next requests
+	std::function<void()> onResult;
+
+	std::mutex mutex;
+	std::deque<std::unique_ptr<Transfer>> queued;
+	std::vector<FetchResult> finished;
+	std::atomic<size_t> pending{};
+
+	std::jthread thread;
+};
@@ -0,0 +1,90 @@
+#include "Memory.h"
+#include "Placement.h"
+#include <new>
+
+void* TrackedResource::do_allocate(size_t bytes, size_t alignment)
+{
+	void* p = upstream->allocate(bytes, alignment);
+
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	const uint64_t live = liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+	while (live > peak && peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed) == false)
+	{
+	}
+	return p;
+}
+
+void TrackedResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	deallocations.fetch_add(1, std::memory_order_relaxed);
+	liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+	upstream->deallocate(p, bytes, alignment);
+}
+
+MemoryStats TrackedResource::Stats() const
+{
+	MemoryStats stats;
+	stats.liveBytes = liveBytes.load(std::memory_order_relaxed);
+	stats.peakBytes = peakBytes.load(std::memory_order_relaxed);
+	stats.allocations = allocations.load(std::memory_order_relaxed);
+	stats.deallocations = deallocations.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void TrackedResource::ResetPeak()
+{
+	peakBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+TrackedResource* Memory::Tracked(MemoryTag tag)
+{
+	// leaked on purpose, static containers elsewhere may still free into them during exit
+	static TrackedResource* resources = [] {
+		void* raw = ::operator new(sizeof(TrackedResource) * (size_t)MemoryTag::Count, std::align_val_t{ alignof(TrackedResource) });
+		TrackedResource* tracked = static_cast<TrackedResource*>(raw);
+		for (size_t t = 0; t < (size_t)MemoryTag::Count; ++t)
+			new (tracked + t) TrackedResource(Memory::Placed((MemoryTag)t));
+		return tracked;
+	}();
+	return &resources[(size_t)tag];
+}
+
+MemoryStats Memory::Stats(MemoryTag tag)
+{
+	return Tracked(tag)->Stats();
+}
+
+const char* Memory::TagName(MemoryTag tag)
+{
+	switch (tag)
+	{
+	case MemoryTag::OrderBook: return "Order books";
+	case MemoryTag::Orders: return "Orders";
+	case MemoryTag::MarketData: return "Market data";
+	case MemoryTag::DepthHistory: return "Depth history";
+	case MemoryTag::TradeTape: return "Trade tape";
+	default: return "Unknown";
+	}
+}
+
+TaggedResource::TaggedResource(MemoryTag tag, AllocatorKind _kind, bool synchronized)
+	: kind{ _kind }
+{
+	std::pmr::memory_resource* upstream = Memory::Tracked(tag);
+	switch (kind)
+	{
+	case AllocatorKind::Monotonic:
+		strategy = std::make_unique<std::pmr::monotonic_buffer_resource>(upstream);
+		break;
+	case AllocatorKind::Pool:
+		if (synchronized)
+			strategy = std::make_unique<std::pmr::synchronized_pool_resource>(upstream);
+		else
+			strategy = std::make_unique<std::pmr::unsynchronized_pool_resource>(upstream);
+		break;
+	default:
+		break;
+	}
+	resource = strategy ? strategy.get() : upstream;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+enum class MemoryTag
+{
+	OrderBook,    // price levels, resting order lists and the order index of every book
+	Orders,       // Order objects together with their shared_ptr control blocks
+	MarketData,   // history columns and the bulk load arena
+	DepthHistory, // recorded order book depth rings
+	TradeTape,    // time and sales chunks
+	Count
+};
+
+enum class AllocatorKind
+{
+	System,    // straight to the tag's tracked resource
+	Monotonic, // bump allocation, nothing is returned before the owner is destroyed
+	Pool       // size class pools, freed blocks are reused
+};
+
+struct MemoryStats
+{
+	uint64_t liveBytes{};
+	uint64_t peakBytes{};
+	uint64_t allocations{};
+	uint64_t deallocations{};
+};
+
+// Counts everything handed out for one tag and forwards to its placed resource.
+// Pool and monotonic resources sit on top of it, so the numbers are what the
+// subsystem really holds from the system, not what its containers asked for.
+class TrackedResource : public std::pmr::memory_resource
+{
+public:
+	explicit TrackedResource(std::pmr::memory_resource* _upstream = std::pmr::new_delete_resource()) : upstream{ _upstream } {}
+
+	MemoryStats Stats() const;
+	// peak restarts from the current live bytes
+	void ResetPeak();
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	std::pmr::memory_resource* upstream;
+
+	// padded, different tags are updated from different threads
+	alignas(64) std::atomic<uint64_t> liveBytes{};
+	std::atomic<uint64_t> peakBytes{};
+	std::atomic<uint64_t> allocations{};
+	std::atomic<uint64_t> deallocations{};
+};
+
+namespace Memory
+{
+	// process wide and never destroyed, so containers may outlive anything that handed it out
+	TrackedResource* Tracked(MemoryTag tag);
+	MemoryStats Stats(MemoryTag tag);
+	const char* TagName(MemoryTag tag);
+}
+
+// An allocation strategy for one owner, drawing from its tag's tracked resource.
+// Everything allocated through Get() must be released before this is destroyed,
+// unless the kind is System.
+class TaggedResource
+{
+public:
+	// synchronized pools are only needed when several threads allocate from the same owner
+	TaggedResource(MemoryTag tag, AllocatorKind kind = AllocatorKind::System, bool synchronized = false);
+
+	TaggedResource(const TaggedResource&) = delete;
+	TaggedResource& operator=(const TaggedResource&) = delete;
+
+	std::pmr::memory_resource* Get() const { return resource; }
+	AllocatorKind Kind() const { return kind; }
+
+private:
+	AllocatorKind kind;
+	std::unique_ptr<std::pmr::memory_resource> strategy; // null for System
+	std::pmr::memory_resource* resource;
+};
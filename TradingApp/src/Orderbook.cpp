@@ -1,23 +1,49 @@
 #include "Orderbook.h"
+#include "Profiler.h"
 
 #ifndef NOMINMAX   /* don't define min() and max(). */
 #define NOMINMAX
 #endif // !NOMINMAX
 #include <chrono>
-
-OrderBook::OrderBook()
+#include <ctime>
+
+OrderBook::OrderBook(OrderBookMode _mode, AllocatorKind _allocator)
+	: mode{ _mode }
+	// containers are only touched under Lock(), orders are released wherever their last reference goes
+	, bookMemory{ MemoryTag::OrderBook, _allocator }
+	, orderMemory{ MemoryTag::Orders, _allocator, _mode == OrderBookMode::Shared }
+	, allData{ bookMemory.Get() }
+	, allBids{ bookMemory.Get() }
+	, allAsks{ bookMemory.Get() }
+	, allOrders{ bookMemory.Get() }
 {
-	GFDPruneThread = std::jthread([this](std::stop_token s) { this->PruneGoodForDay(s); });
+	if (mode == OrderBookMode::Shared)
+		GFDPruneThread = std::jthread([this](std::stop_token s) { this->PruneGoodForDay(s); });
 }
 
 OrderBook::~OrderBook()
 {
-	std::this_thread::sleep_for(std::chrono::seconds(4));
+	if (GFDPruneThread.joinable() == false)
+		return;
 
+	// the stop request wakes the prune thread out of its wait for the day end
 	GFDPruneThread.request_stop();
 	GFDPruneThread.join();
 }
 
+OrderRef OrderBook::CreateOrder(OrderType type, OrderID id, Side side, Price price, Quantity quantity, AccountID account)
+{
+	auto lock = Lock();
+	return std::allocate_shared<Order>(std::pmr::polymorphic_allocator<Order>(orderMemory.Get()), type, id, side, price, quantity, account);
+}
+
+OrderRef OrderBook::CreateIceberg(OrderID id, Side side, Price price, Quantity quantity, Quantity displayQuantity, AccountID account)
+{
+	OrderRef order = CreateOrder(OrderType::Iceberg, id, side, price, quantity, account);
+	order->ToIceberg(displayQuantity);
+	return order;
+}
+
 bool OrderBook::CanMatch(Side side, Price price) const
 {
 	switch (side)
@@ -89,6 +115,7 @@ bool OrderBook::CanFullyFill(Side side, Price price, Quantity quantity) const
 
 Trades OrderBook::MatchOrders()
 {
+	PROFILE_SCOPE("OrderBook::MatchOrders");
 	Trades trades;
 	trades.reserve(allOrders.size());
 
@@ -122,6 +149,25 @@ Trades OrderBook::MatchOrders()
 
 			bid->Fill(fillQuantity);
 			ask->Fill(fillQuantity);
+			risk.OnFill(*bid, fillQuantity);
+			risk.OnFill(*ask, fillQuantity);
+
+			// keep level totals in step, filled orders leave their level
+			OnOrderMatched(bid->price, fillQuantity, bid->IsFilled());
+			OnOrderMatched(ask->price, fillQuantity, ask->IsFilled());
+
+			// a refreshed iceberg slice goes to the back of its level. Splicing moves the list
+			// node itself, so the order keeps its id, its allocation and its index entry
+			if (Quantity slice = bid->Replenish())
+			{
+				bids.splice(bids.end(), bids, bids.begin());
+				UpdateLevelData(bid->price, slice, LevelData::Action::Refresh);
+			}
+			if (Quantity slice = ask->Replenish())
+			{
+				asks.splice(asks.end(), asks, asks.begin());
+				UpdateLevelData(ask->price, slice, LevelData::Action::Refresh);
+			}
 
 			if (bid->IsFilled())
 			{
@@ -158,7 +204,8 @@ Trades OrderBook::MatchOrders()
 		auto& order = bids.front();
 		if (order->type == OrderType::FillAndKill)
 		{
-			CancelOrder(order->id);
+			// callers already hold the lock
+			CancelOrderInternal(order->id);
 		}
 	}
 
@@ -168,7 +215,7 @@ Trades OrderBook::MatchOrders()
 		auto& order = asks.front();
 		if (order->type == OrderType::FillAndKill)
 		{
-			CancelOrder(order->id);
+			CancelOrderInternal(order->id);
 		}
 	}
 
@@ -177,7 +224,8 @@ Trades OrderBook::MatchOrders()
 
 Trades OrderBook::AddOrder(OrderRef _order)
 {
-	std::scoped_lock lock(ordersMutex);
+	PROFILE_SCOPE("OrderBook::AddOrder");
+	auto lock = Lock();
 
 	if (allOrders.contains(_order->id))
 		return {};
@@ -208,15 +256,27 @@ Trades OrderBook::AddOrder(OrderRef _order)
 	break;
 	case OrderType::GoodForDay:
 	break;
+	case OrderType::Iceberg:
+	{
+		// made by CreateIceberg, a plain order of this type would have nothing on display
+		if (_order->displayQuantity == 0)
+		{
+			return {};
+		}
+	}
+	break;
 	case OrderType::Market:
 	{
-		if (_order->side == Side::Buy)
+		// priced at the far side of the opposite book, so it sweeps everything there is
+		if (_order->side == Side::Buy && allAsks.empty() == false)
 		{
 			const auto& [worstAsk, _] = *allAsks.rbegin();
+			_order->ToGoodTillCancel(worstAsk);
 		}
-		else if (_order->side == Side::Sell)
+		else if (_order->side == Side::Sell && allBids.empty() == false)
 		{
 			const auto& [worstBid, _] = *allBids.rbegin();
+			_order->ToGoodTillCancel(worstBid);
 		}
 		else
 		{
@@ -229,6 +289,9 @@ Trades OrderBook::AddOrder(OrderRef _order)
 	break;
 	}
 
+	if (risk.Check(*_order) != RiskReject::None)
+		return {};
+
 	OrderReferences::iterator iter;
 	if (_order->side == Side::Buy)
 	{
@@ -246,19 +309,27 @@ Trades OrderBook::AddOrder(OrderRef _order)
 	allOrders.insert({ _order->id, OrderEntry{_order,iter}});
 
 	OnOrderAdded(_order);
-	return MatchOrders();
+	risk.OnAdded(*_order);
+
+	Trades trades = MatchOrders();
+	// trades are priced at the resting orders, the band follows the last of them
+	if (trades.empty() == false)
+		risk.SetReferencePrice(_order->side == Side::Buy ? trades.back().askTrade.price : trades.back().bidTrade.price);
+	return trades;
 }
 
 void OrderBook::CancelOrder(OrderID _orderID)
 {
-	std::scoped_lock lock(ordersMutex);
+	PROFILE_SCOPE("OrderBook::CancelOrder");
+	auto lock = Lock();
 
 	CancelOrderInternal(_orderID);	
 }
 
 void OrderBook::CancelOrders(OrderIDs orders)
 {
-	std::scoped_lock lock(ordersMutex);
+	PROFILE_SCOPE("OrderBook::CancelOrders");
+	auto lock = Lock();
 
 	for (OrderID id : orders)
 	{
@@ -268,14 +339,47 @@ void OrderBook::CancelOrders(OrderIDs orders)
 
 Trades OrderBook::ModifyOrder(OrderModify _order)
 {
-	if (allOrders.contains(_order.orderID) == false)
+	OrderType type;
+	AccountID account;
+	Quantity displayQuantity;
 	{
-		return {};
+		// looked up and cancelled under one lock, another thread may be changing the index
+		auto lock = Lock();
+		auto found = allOrders.find(_order.orderID);
+		if (found == allOrders.end())
+		{
+			return {};
+		}
+
+		// read before cancelling, the entry is gone afterwards
+		const Order& existing = *found->second.order;
+		type = existing.type;
+		account = existing.account;
+		displayQuantity = existing.displayQuantity;
+		CancelOrderInternal(_order.orderID);
 	}
 
-	const auto& [existingOrder, _] = allOrders[_order.orderID];
-	CancelOrder(_order.orderID);
-	return AddOrder(_order.CreateOrder(existingOrder->type));
+	if (type == OrderType::Iceberg)
+		return AddOrder(CreateIceberg(_order.orderID, _order.side, _order.price, _order.quantity, displayQuantity, account));
+	return AddOrder(CreateOrder(type, _order.orderID, _order.side, _order.price, _order.quantity, account));
+}
+
+void OrderBook::CancelGoodForDay()
+{
+	PROFILE_SCOPE("OrderBook::CancelGoodForDay");
+	auto lock = Lock();
+
+	OrderIDs ordersToCancel;
+	for (const auto& [id, entry] : allOrders)
+	{
+		if (entry.order->type == OrderType::GoodForDay)
+			ordersToCancel.push_back(id);
+	}
+
+	for (OrderID id : ordersToCancel)
+	{
+		CancelOrderInternal(id);
+	}
 }
 
 OrderBookLevelInfos OrderBook::GetOrderInfos() const
@@ -305,62 +409,131 @@ OrderBookLevelInfos OrderBook::GetOrderInfos() const
 	return OrderBookLevelInfos{ std::move(bidInfos), std::move(askInfos) };
 }
 
-void OrderBook::PruneGoodForDay(std::stop_token stoken)
+void OrderBook::TopLevels(size_t depth, LevelInfo* outBids, size_t& outNumBids, LevelInfo* outAsks, size_t& outNumAsks)
+{
+	auto lock = Lock();
+	outNumBids = 0;
+	outNumAsks = 0;
+
+	// allData holds both sides in price order and they never overlap, so each side is
+	// one lookup of its best price and a walk away from the spread
+	auto bestBid = allBids.empty() ? allData.end() : allData.find(allBids.begin()->first);
+	if (bestBid != allData.end())
+	{
+		for (auto it = std::make_reverse_iterator(std::next(bestBid)); it != allData.rend() && outNumBids < depth; ++it)
+			outBids[outNumBids++] = LevelInfo{ it->first, it->second.quantity };
+	}
+	auto bestAsk = allAsks.empty() ? allData.end() : allData.find(allAsks.begin()->first);
+	for (auto it = bestAsk; it != allData.end() && outNumAsks < depth; ++it)
+		outAsks[outNumAsks++] = LevelInfo{ it->first, it->second.quantity };
+}
+
+size_t OrderBook::Size()
+{
+	auto lock = Lock();
+	return allOrders.size();
+}
+
+void OrderBook::Reserve(size_t orders)
+{
+	PROFILE_SCOPE("OrderBook::Reserve");
+	auto lock = Lock();
+	allOrders.reserve(orders);
+	if (orderMemory.Kind() != AllocatorKind::Pool)
+		return;
+
+	// freed straight back, the pools keep the chunks they grew for the next orders
+	std::vector<OrderRef> warm;
+	warm.reserve(orders);
+	for (size_t i = 0; i < orders; ++i)
+		warm.push_back(std::allocate_shared<Order>(std::pmr::polymorphic_allocator<Order>(orderMemory.Get()), OrderType::GoodTillCancel, (OrderID)i, Side::Buy, 0, 1, 0));
+}
+
+void OrderBook::SetRiskLimits(AccountID account, const RiskLimits& limits)
 {
-	printf("Starting prune thread  \n");
+	auto lock = Lock();
+	risk.SetLimits(account, limits);
+}
+
+void OrderBook::SetReferencePrice(Price price)
+{
+	auto lock = Lock();
+	risk.SetReferencePrice(price);
+}
+
+AccountExposure OrderBook::Exposure(AccountID account)
+{
+	auto lock = Lock();
+	return risk.Exposure(account);
+}
+
+uint64_t OrderBook::RiskRejects(RiskReject reason)
+{
+	auto lock = Lock();
+	return risk.Rejects(reason);
+}
 
-	constexpr auto dayEndHour = std::chrono::hours(16); // 4pm
+void OrderBook::PruneGoodForDay(std::stop_token stoken)
+{
+	constexpr int dayEndHour = 16; // 4pm local time
 
-	int count = 0;
+	// nothing notifies this but the stop request, the wait only ends at the day end or on stop
+	std::mutex waitMutex;
+	std::condition_variable_any wake;
 
 	while (stoken.stop_requested() == false)
 	{
-		const auto now = std::chrono::system_clock::now();
-		const auto now_c = std::chrono::system_clock::to_time_t(now);
-
-		tm now_parts;
-		localtime_s(&now_parts, &now_c);
+		const time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+		tm dayEnd;
+#ifdef _WIN32
+		localtime_s(&dayEnd, &now);
+#else
+		localtime_r(&now, &dayEnd);
+#endif
+		if (dayEnd.tm_hour >= dayEndHour)
+			dayEnd.tm_mday += 1;
+		dayEnd.tm_hour = dayEndHour;
+		dayEnd.tm_min = 0;
+		dayEnd.tm_sec = 0;
+		dayEnd.tm_isdst = -1;
 
-		if (now_parts.tm_hour >= dayEndHour.count())
 		{
-			now_parts.tm_mday += 1;
+			std::unique_lock lock(waitMutex);
+			wake.wait_until(lock, stoken, std::chrono::system_clock::from_time_t(mktime(&dayEnd)), [] { return false; });
 		}
-		now_parts.tm_min = 0;
-		now_parts.tm_sec = 0;
+		if (stoken.stop_requested())
+			break;
 
-		auto next = std::chrono::system_clock::from_time_t(mktime(&now_parts));
-		auto till = next - now + std::chrono::milliseconds(100);
+		// through Lock() like any other caller, so the time it holds the book shows in LockContention
+		CancelGoodForDay();
+	}
+}
 
-		OrderIDs ordersToCancel;
-		{
-			std::unique_lock lock(this->ordersMutex);
-			// wait until day ends or stop token requested
-			std::condition_variable_any().wait_until(lock, stoken, now + std::chrono::milliseconds(100), [] { return false; });
-			if (stoken.stop_requested())
-			{
-				printf("Prune worker is requested to stop\n");
-				break;
-			}
-			// mutex is aquired by wait_until
-			for (auto& [entryID,entry] : allOrders)
-			{
-				const auto& [order, _] = entry;
-				if (order->type == OrderType::GoodForDay)
-				{
-					ordersToCancel.push_back(order->id);
-				}
-			}
-			printf("Prune Iteration %2d \n", ++count);
-		}
+std::unique_lock<std::mutex> OrderBook::Lock()
+{
+	if (mode == OrderBookMode::SingleThreaded)
+		return {};
 
-		if (ordersToCancel.size())
-		{
-			printf("GoodForDay orders pruned [%llu]\n", ordersToCancel.size());
-			CancelOrders(ordersToCancel);
-		}
+	// the uncontended path is a single try_lock, only waits are timed
+	std::unique_lock<std::mutex> lock(ordersMutex, std::try_to_lock);
+	if (lock.owns_lock() == false)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		lock.lock();
+		lockContended.fetch_add(1, std::memory_order_relaxed);
+		lockWaitNanoseconds.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
 	}
+	lockAcquisitions.fetch_add(1, std::memory_order_relaxed);
+	return lock;
+}
 
-	printf("Prune thread shutdown \n");
+LockStats OrderBook::LockContention() const
+{
+	return LockStats{
+		lockAcquisitions.load(std::memory_order_relaxed),
+		lockContended.load(std::memory_order_relaxed),
+		lockWaitNanoseconds.load(std::memory_order_relaxed) };
 }
 
 void OrderBook::CancelOrderInternal(OrderID _orderID)
@@ -399,11 +572,13 @@ void OrderBook::CancelOrderInternal(OrderID _orderID)
 
 void OrderBook::OnOrderAdded(OrderRef order)
 {
-	UpdateLevelData(order->price, order->initialQuantity, LevelData::Action::Add);
+	// only the displayed part of an iceberg counts towards its level
+	UpdateLevelData(order->price, order->remainingQuantity, LevelData::Action::Add);
 }
 
 void OrderBook::OnOrderCancelled(OrderRef order)
 {
+	risk.OnCancel(*order);
 	UpdateLevelData(order->price, order->remainingQuantity, LevelData::Action::Remove);
 }
 
@@ -424,6 +599,9 @@ void OrderBook::UpdateLevelData(Price price, Quantity quantity, LevelData::Actio
 		data.quantity += quantity;
 	}
 	break;	
+	case OrderBook::LevelData::Action::Refresh:
+		data.quantity += quantity;
+	break;
 	case OrderBook::LevelData::Action::Remove:
 		data.count -= 1; // only if remove
 	case OrderBook::LevelData::Action::Match:
@@ -1,10 +1,15 @@
 #pragma once
+#include "Memory.h"
 #include "Orders.h"
+#include "PreTradeRisk.h"
 #include <vector>
 #include <unordered_map>
 #include <map>
 #include <algorithm>
 #include <numeric>
+#include <mutex>
+#include <atomic>
+#include <optional>
 
 #include <thread>
 #include <condition_variable>
@@ -77,10 +82,24 @@ public:
 
 using Trades = std::vector<Trade>;
 
+enum class OrderBookMode
+{
+	Shared,         // guarded by a mutex, GoodForDay orders pruned by a background thread at 4pm local time
+	SingleThreaded  // no locking and no prune thread, for books owned by one thread
+};
+
+struct LockStats
+{
+	uint64_t acquisitions{};
+	uint64_t contended{};       // found the lock held by another thread
+	uint64_t waitNanoseconds{}; // spent waiting in those
+};
+
 class OrderBook
 {
 public:
-	OrderBook();
+	// allocator picks the strategy behind the book's containers and the orders made by CreateOrder
+	explicit OrderBook(OrderBookMode _mode = OrderBookMode::Shared, AllocatorKind _allocator = AllocatorKind::System);
 	~OrderBook();
 
 	struct OrderEntry
@@ -98,25 +117,50 @@ public:
 		{
 			Add,
 			Remove,
-			Match
+			Match,
+			Refresh  // an iceberg's next slice comes on display
 		};
 	};
 
+	// allocates the order and its control block from this book's order memory.
+	// With a pool or monotonic allocator the order must not outlive the book.
+	OrderRef CreateOrder(OrderType type, OrderID id, Side side, Price price, Quantity quantity, AccountID account = 0);
+	// quantity in total, displayQuantity of it shown at a time
+	OrderRef CreateIceberg(OrderID id, Side side, Price price, Quantity quantity, Quantity displayQuantity, AccountID account = 0);
+
 	bool CanMatch(Side side, Price price) const;
 	bool CanFullyFill(Side side, Price price, Quantity initialQuantity) const;
 	Trades MatchOrders();
+	// orders that fail the account's risk checks are dropped like any other rejected order
 	Trades AddOrder(OrderRef _order);
 	void CancelOrder(OrderID _orderID);
 	void CancelOrders(OrderIDs orders);
 	Trades ModifyOrder(OrderModify _order);
+	// ends the trading day, cancelling every GoodForDay order
+	void CancelGoodForDay();
 	OrderBookLevelInfos GetOrderInfos() const;
-
-	size_t Size() { return allOrders.size(); }
+	// best depth levels of each side into caller storage, O(depth) and allocation free
+	void TopLevels(size_t depth, LevelInfo* outBids, size_t& outNumBids, LevelInfo* outAsks, size_t& outNumAsks);
+
+	size_t Size();
+	// sizes the order index and, with a pool allocator, fills the order pools for that many
+	// resting orders, so their memory is mapped now, by the calling thread, instead of mid-session
+	void Reserve(size_t orders);
+
+	// pre-trade risk, checked and updated under the book's own lock
+	void SetRiskLimits(AccountID account, const RiskLimits& limits);
+	void SetReferencePrice(Price price);
+	AccountExposure Exposure(AccountID account);
+	uint64_t RiskRejects(RiskReject reason);
+
+	// totals since construction, always zero for SingleThreaded books
+	LockStats LockContention() const;
 private:
 
 	void PruneGoodForDay(std::stop_token stoken); 
 
 	void CancelOrderInternal(OrderID orderID);
+	std::unique_lock<std::mutex> Lock();
 
 	void OnOrderAdded(OrderRef order);
 	void OnOrderCancelled(OrderRef order);
@@ -124,11 +168,21 @@ private:
 
 	void UpdateLevelData(Price price, Quantity quantity, LevelData::Action action);
 	
+	OrderBookMode mode;
 	std::mutex ordersMutex;
+	std::atomic<uint64_t> lockAcquisitions{};
+	std::atomic<uint64_t> lockContended{};
+	std::atomic<uint64_t> lockWaitNanoseconds{};
 	std::jthread GFDPruneThread;
 
-	std::map< Price, LevelData > allData;
-	std::map< Price, OrderReferences, std::greater<int> > allBids;
-	std::map< Price, OrderReferences, std::less<int>    > allAsks;
-	std::unordered_map< OrderID, OrderEntry > allOrders;
+	// declared before the containers so they outlive them
+	TaggedResource bookMemory;
+	TaggedResource orderMemory;
+
+	std::pmr::map< Price, LevelData > allData;
+	std::pmr::map< Price, OrderReferences, std::greater<int> > allBids;
+	std::pmr::map< Price, OrderReferences, std::less<int>    > allAsks;
+	std::pmr::unordered_map< OrderID, OrderEntry > allOrders;
+
+	PreTradeRisk risk;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Orders.h"
+#include <algorithm>
 
-Order::Order(OrderType _type, OrderID _id, Side _side, Price _price, Quantity _quantity)
+Order::Order(OrderType _type, OrderID _id, Side _side, Price _price, Quantity _quantity, AccountID _account)
 	:
 	type{ _type }
 	, id{ _id }
@@ -8,11 +9,12 @@ Order::Order(OrderType _type, OrderID _id, Side _side, Price _price, Quantity _q
 	, price{_price}
 	, initialQuantity{ _quantity }
 	, remainingQuantity{_quantity}
+	, account{ _account }
 {}
 
 bool Order::IsFilled() const
 {
-	return remainingQuantity == 0;
+	return remainingQuantity == 0 && hiddenQuantity == 0;
 }
 
 void Order::Fill(Quantity quantity)
@@ -25,5 +27,24 @@ void Order::Fill(Quantity quantity)
 void Order::ToGoodTillCancel(Price _price)
 {
 	type = OrderType::GoodTillCancel;
-	price = price;
+	price = _price;
+}
+
+void Order::ToIceberg(Quantity _displayQuantity)
+{
+	type = OrderType::Iceberg;
+	displayQuantity = std::max<Quantity>(_displayQuantity, 1);
+	const Quantity open = OpenQuantity();
+	remainingQuantity = std::min(displayQuantity, open);
+	hiddenQuantity = open - remainingQuantity;
+}
+
+Quantity Order::Replenish()
+{
+	if (remainingQuantity != 0 || hiddenQuantity == 0)
+		return 0;
+
+	remainingQuantity = std::min(displayQuantity, hiddenQuantity);
+	hiddenQuantity -= remainingQuantity;
+	return remainingQuantity;
 }
@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include <list>
+#include <memory_resource>
 
 enum class OrderType
 {
@@ -12,6 +13,7 @@ enum class OrderType
 	FillOrKill,
 	GoodForDay,
 	Market,
+	Iceberg,  // rests like GoodTillCancel, showing displayQuantity at a time
 
 };
 
@@ -24,26 +26,38 @@ enum class Side
 using Price = int32_t;
 using Quantity = uint32_t;
 using OrderID = uint64_t;
+using AccountID = uint32_t;
 using OrderIDs = std::vector<OrderID>;
 
 class Order
 {
 public:
-	Order(OrderType _type, OrderID _id, Side _side, Price _price, Quantity _quantity);
+	Order(OrderType _type, OrderID _id, Side _side, Price _price, Quantity _quantity, AccountID _account = 0);
 
+	// icebergs only count as filled once the reserve is used up too
 	bool IsFilled() const;
 
 	void Fill(Quantity quantity);
 
 	void ToGoodTillCancel(Price _price);
+	// shows at most _displayQuantity, the rest is held back as a hidden reserve
+	void ToIceberg(Quantity _displayQuantity);
+	// moves the next slice of the reserve on display once the current one is gone,
+	// returns its quantity or 0 when nothing was refreshed
+	Quantity Replenish();
+	// displayed and hidden quantity together
+	Quantity OpenQuantity() const { return remainingQuantity + hiddenQuantity; }
 
 	Side side{};
 	OrderType type{};
 	OrderID id{};
 	Price price{};
 	Quantity initialQuantity{};
-	Quantity remainingQuantity{};
+	Quantity remainingQuantity{}; // displayed part for icebergs
+	Quantity displayQuantity{};
+	Quantity hiddenQuantity{};
+	AccountID account{};
 };
 
 using OrderRef = std::shared_ptr<Order>;
-using OrderReferences = std::list<OrderRef>;
\ No newline at end of file
+using OrderReferences = std::pmr::list<OrderRef>;
\ No newline at end of file
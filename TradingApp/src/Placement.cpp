@@ -0,0 +1,414 @@
+#include "Placement.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#if defined(__linux__)
+#include <cstdio>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PLACEMENT_LINUX 1
+#define PLACEMENT_WINDOWS 0
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#define PLACEMENT_LINUX 0
+#define PLACEMENT_WINDOWS 1
+#else
+#define PLACEMENT_LINUX 0
+#define PLACEMENT_WINDOWS 0
+#endif
+
+namespace
+{
+	constexpr size_t SMALL_PAGE = 4096;
+	// pages asked about per system call while taking stats
+	constexpr size_t QUERY_PAGES = 4096;
+
+	size_t RoundUp(size_t bytes, size_t to)
+	{
+		return (bytes + to - 1) / to * to;
+	}
+
+#if PLACEMENT_LINUX
+	constexpr int MPOL_PREFERRED_MODE = 1;
+
+	// preferred rather than bound, a full node spills over instead of failing the allocation
+	void PreferNode(void* p, size_t bytes, unsigned node)
+	{
+		unsigned long mask = 1ul << node;
+		syscall(SYS_mbind, p, bytes, MPOL_PREFERRED_MODE, &mask, sizeof(mask) * 8 + 1, 0u);
+	}
+
+	// adds the AnonHugePages of every mapping overlapping a block, capped at the overlap
+	uint64_t HugeBytes(const std::map<void*, size_t>& ranges)
+	{
+		FILE* smaps = std::fopen("/proc/self/smaps", "r");
+		if (smaps == nullptr)
+			return 0;
+
+		uint64_t total = 0;
+		uint64_t overlap = 0;
+		char line[512];
+		while (std::fgets(line, sizeof(line), smaps))
+		{
+			unsigned long begin, end;
+			unsigned long kilobytes;
+			if (std::sscanf(line, "%lx-%lx ", &begin, &end) == 2)
+			{
+				// blocks never overlap, so walking back from the last one starting inside the mapping finds them all
+				overlap = 0;
+				for (auto it = ranges.lower_bound((void*)end); it != ranges.begin();)
+				{
+					--it;
+					const uintptr_t first = std::max<uintptr_t>((uintptr_t)it->first, begin);
+					const uintptr_t last = std::min<uintptr_t>((uintptr_t)it->first + it->second, end);
+					if (first >= last)
+						break;
+					overlap += last - first;
+				}
+			}
+			else if (overlap && std::sscanf(line, "AnonHugePages: %lu kB", &kilobytes) == 1)
+			{
+				total += std::min<uint64_t>((uint64_t)kilobytes * 1024, overlap);
+			}
+		}
+		std::fclose(smaps);
+		return total;
+	}
+#endif
+}
+
+void PlacedResource::Configure(const PlacementConfig& _config)
+{
+	std::lock_guard lock(mutex);
+	config = _config;
+}
+
+PlacementConfig PlacedResource::Config() const
+{
+	std::lock_guard lock(mutex);
+	return config;
+}
+
+void* PlacedResource::do_allocate(size_t bytes, size_t alignment)
+{
+	if (bytes >= LARGE_BLOCK && alignment <= SMALL_PAGE)
+	{
+		std::lock_guard lock(mutex);
+		if (config.pages != PagePolicy::Default || config.localNode || config.prefault)
+		{
+			Block block;
+			if (void* p = Map(bytes, block))
+			{
+				blocks.emplace(p, block);
+				return p;
+			}
+		}
+	}
+	return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void PlacedResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	if (bytes >= LARGE_BLOCK && alignment <= SMALL_PAGE)
+	{
+		std::lock_guard lock(mutex);
+		auto found = blocks.find(p);
+		if (found != blocks.end())
+		{
+			Unmap(p, found->second);
+			blocks.erase(found);
+			return;
+		}
+	}
+	std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+#if PLACEMENT_LINUX
+
+void* PlacedResource::Map(size_t bytes, Block& outBlock)
+{
+	void* p = MAP_FAILED;
+	if (config.pages == PagePolicy::Explicit)
+	{
+		outBlock.bytes = RoundUp(bytes, HUGE_PAGE);
+		outBlock.explicitHuge = true;
+		p = mmap(nullptr, outBlock.bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	}
+
+	if (p == MAP_FAILED)
+	{
+		outBlock.explicitHuge = false;
+		outBlock.bytes = RoundUp(bytes, SMALL_PAGE);
+		if (config.pages == PagePolicy::Default || outBlock.bytes < HUGE_PAGE)
+		{
+			p = mmap(nullptr, outBlock.bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		}
+		else
+		{
+			// over-map and trim, only whole aligned 2 MB ranges can become huge pages
+			outBlock.bytes = RoundUp(bytes, HUGE_PAGE);
+			void* raw = mmap(nullptr, outBlock.bytes + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (raw != MAP_FAILED)
+			{
+				const uintptr_t start = RoundUp((uintptr_t)raw, HUGE_PAGE);
+				const size_t head = start - (uintptr_t)raw;
+				if (head)
+					munmap(raw, head);
+				munmap((char*)start + outBlock.bytes, HUGE_PAGE - head);
+				p = (void*)start;
+				madvise(p, outBlock.bytes, MADV_HUGEPAGE);
+			}
+		}
+		if (p == MAP_FAILED)
+			return nullptr;
+	}
+
+	// policy has to be set before the first touch, that is what places a page
+	if (config.localNode)
+		PreferNode(p, outBlock.bytes, Memory::CurrentNode());
+	if (config.prefault)
+	{
+		const size_t step = outBlock.explicitHuge ? HUGE_PAGE : SMALL_PAGE;
+		for (size_t offset = 0; offset < outBlock.bytes; offset += step)
+			static_cast<volatile char*>(p)[offset] = 0;
+	}
+	return p;
+}
+
+void PlacedResource::Unmap(void* p, const Block& block)
+{
+	munmap(p, block.bytes);
+}
+
+PlacementStats PlacedResource::Stats() const
+{
+	PlacementStats stats;
+	std::map<void*, size_t> ranges;
+	{
+		std::lock_guard lock(mutex);
+		for (const auto& [p, block] : blocks)
+		{
+			ranges.emplace(p, block.bytes);
+			stats.mappedBytes += block.bytes;
+			if (block.explicitHuge)
+				stats.hugeBytes += block.bytes;
+		}
+		stats.blocks = blocks.size();
+	}
+
+	// the kernel is asked after the lock is released, so allocations are not held up for it;
+	// a block unmapped meanwhile only reads as not resident
+	std::vector<void*> pages;
+	std::vector<int> status;
+	pages.reserve(QUERY_PAGES);
+	status.resize(QUERY_PAGES);
+	auto flush = [&] {
+		if (pages.empty())
+			return;
+		if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0)
+			std::fill(status.begin(), status.begin() + pages.size(), -1);
+		for (size_t i = 0; i < pages.size(); ++i)
+		{
+			if (status[i] >= 0 && (size_t)status[i] < PlacementStats::MAX_NODES)
+				stats.nodeBytes[status[i]] += SMALL_PAGE;
+			else
+				stats.otherBytes += SMALL_PAGE;
+		}
+		pages.clear();
+	};
+	for (const auto& [p, bytes] : ranges)
+	{
+		for (size_t offset = 0; offset < bytes; offset += SMALL_PAGE)
+		{
+			pages.push_back((char*)p + offset);
+			if (pages.size() == QUERY_PAGES)
+				flush();
+		}
+	}
+	flush();
+
+	stats.hugeBytes += HugeBytes(ranges);
+	stats.hugeBytes = std::min(stats.hugeBytes, stats.mappedBytes);
+	return stats;
+}
+
+#elif PLACEMENT_WINDOWS
+
+void* PlacedResource::Map(size_t bytes, Block& outBlock)
+{
+	const DWORD node = config.localNode ? Memory::CurrentNode() : NUMA_NO_PREFERRED_NODE;
+	void* p = nullptr;
+	// large pages need SeLockMemoryPrivilege, without it this fails and the block gets small pages
+	const size_t largePage = GetLargePageMinimum();
+	if (config.pages == PagePolicy::Explicit && largePage)
+	{
+		outBlock.bytes = RoundUp(bytes, largePage);
+		outBlock.explicitHuge = true;
+		p = VirtualAllocExNuma(GetCurrentProcess(), nullptr, outBlock.bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, node);
+	}
+	if (p == nullptr)
+	{
+		// Windows has no transparent huge pages, Transparent only places the block
+		outBlock.bytes = RoundUp(bytes, SMALL_PAGE);
+		outBlock.explicitHuge = false;
+		p = VirtualAllocExNuma(GetCurrentProcess(), nullptr, outBlock.bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+		if (p == nullptr)
+			return nullptr;
+	}
+
+	if (config.prefault && outBlock.explicitHuge == false)
+	{
+		for (size_t offset = 0; offset < outBlock.bytes; offset += SMALL_PAGE)
+			static_cast<volatile char*>(p)[offset] = 0;
+	}
+	return p;
+}
+
+void PlacedResource::Unmap(void* p, const Block&)
+{
+	VirtualFree(p, 0, MEM_RELEASE);
+}
+
+PlacementStats PlacedResource::Stats() const
+{
+	PlacementStats stats;
+	std::vector<std::pair<void*, size_t>> ranges;
+	{
+		std::lock_guard lock(mutex);
+		ranges.reserve(blocks.size());
+		for (const auto& [p, block] : blocks)
+		{
+			ranges.emplace_back(p, block.bytes);
+			stats.mappedBytes += block.bytes;
+		}
+		stats.blocks = blocks.size();
+	}
+
+	// queried without the lock, a block released meanwhile only reads as not resident
+	std::vector<PSAPI_WORKING_SET_EX_INFORMATION> pages;
+	pages.reserve(QUERY_PAGES);
+	auto flush = [&] {
+		if (pages.empty())
+			return;
+		if (QueryWorkingSetEx(GetCurrentProcess(), pages.data(), (DWORD)(pages.size() * sizeof(pages[0]))) == FALSE)
+		{
+			for (auto& page : pages)
+				page.VirtualAttributes.Flags = 0;
+		}
+		for (const auto& page : pages)
+		{
+			const auto& attributes = page.VirtualAttributes;
+			if (attributes.Valid && attributes.Node < PlacementStats::MAX_NODES)
+				stats.nodeBytes[attributes.Node] += SMALL_PAGE;
+			else
+				stats.otherBytes += SMALL_PAGE;
+			if (attributes.Valid && attributes.LargePage)
+				stats.hugeBytes += SMALL_PAGE;
+		}
+		pages.clear();
+	};
+	for (const auto& [p, bytes] : ranges)
+	{
+		for (size_t offset = 0; offset < bytes; offset += SMALL_PAGE)
+		{
+			PSAPI_WORKING_SET_EX_INFORMATION page{};
+			page.VirtualAddress = (char*)p + offset;
+			pages.push_back(page);
+			if (pages.size() == QUERY_PAGES)
+				flush();
+		}
+	}
+	flush();
+	return stats;
+}
+
+#else
+
+// nowhere to ask for placement, every request stays with new/delete
+void* PlacedResource::Map(size_t, Block&)
+{
+	return nullptr;
+}
+
+void PlacedResource::Unmap(void*, const Block&)
+{
+}
+
+PlacementStats PlacedResource::Stats() const
+{
+	return PlacementStats{};
+}
+
+#endif
+
+PlacedResource* Memory::Placed(MemoryTag tag)
+{
+	// leaked like the tracked resources above them
+	static PlacedResource* resources = new PlacedResource[(size_t)MemoryTag::Count];
+	return &resources[(size_t)tag];
+}
+
+void Memory::SetPlacement(MemoryTag tag, const PlacementConfig& config)
+{
+	Placed(tag)->Configure(config);
+}
+
+PlacementStats Memory::Placement(MemoryTag tag)
+{
+	return Placed(tag)->Stats();
+}
+
+unsigned Memory::CurrentNode()
+{
+#if PLACEMENT_LINUX
+	unsigned cpu = 0, node = 0;
+	if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+		return 0;
+	return node;
+#elif PLACEMENT_WINDOWS
+	PROCESSOR_NUMBER processor;
+	GetCurrentProcessorNumberEx(&processor);
+	USHORT node = 0;
+	if (GetNumaProcessorNodeEx(&processor, &node) == FALSE || node == 0xffff)
+		return 0;
+	return node;
+#else
+	return 0;
+#endif
+}
+
+unsigned Memory::NodeCount()
+{
+#if PLACEMENT_LINUX
+	unsigned count = 0;
+	while (count < 64 && access(("/sys/devices/system/node/node" + std::to_string(count)).c_str(), F_OK) == 0)
+		++count;
+	return std::max(count, 1u);
+#elif PLACEMENT_WINDOWS
+	ULONG highest = 0;
+	if (GetNumaHighestNodeNumber(&highest) == FALSE)
+		return 1;
+	return (unsigned)highest + 1;
+#else
+	return 1;
+#endif
+}
+
+bool Memory::ParsePagePolicy(const char* name, PagePolicy& outPolicy)
+{
+	if (std::strcmp(name, "default") == 0)
+		outPolicy = PagePolicy::Default;
+	else if (std::strcmp(name, "transparent") == 0)
+		outPolicy = PagePolicy::Transparent;
+	else if (std::strcmp(name, "explicit") == 0)
+		outPolicy = PagePolicy::Explicit;
+	else
+		return false;
+	return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "Memory.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+
+enum class PagePolicy
+{
+	Default,     // small pages from new/delete
+	Transparent, // mapped on their own, 2 MB aligned and advised for transparent huge pages
+	Explicit     // from the reserved huge page pool, Transparent while the pool is empty
+};
+
+struct PlacementConfig
+{
+	PagePolicy pages{ PagePolicy::Default };
+	bool localNode{ false }; // prefer the NUMA node of the thread that allocates the block
+	bool prefault{ false };  // touch every page when the block is mapped, from that same thread
+};
+
+struct PlacementStats
+{
+	static constexpr size_t MAX_NODES = 8;
+
+	uint64_t mappedBytes{};   // held in blocks this layer mapped itself
+	uint64_t hugeBytes{};     // of those, backed by huge pages according to the kernel
+	uint64_t nodeBytes[MAX_NODES]{}; // resident, by NUMA node
+	uint64_t otherBytes{};    // not resident yet, or on a node past MAX_NODES
+	size_t blocks{};
+};
+
+// The bottom of a tag's allocation stack, below its TrackedResource.
+// Requests of LARGE_BLOCK bytes or more, which are the chunks pools and monotonic
+// arenas carve orders and levels from, hash bucket arrays and history columns,
+// are mapped directly when a policy is set, so they can sit on huge pages and on
+// the node of the thread that owns them. Smaller requests always go to new/delete.
+// The policy only applies to blocks mapped after it is set, and nodes follow the
+// allocating thread, so owners should size their memory from the thread they run on.
+class PlacedResource : public std::pmr::memory_resource
+{
+public:
+	static constexpr size_t LARGE_BLOCK = 64 << 10;
+	static constexpr size_t HUGE_PAGE = 2 << 20;
+
+	void Configure(const PlacementConfig& config);
+	PlacementConfig Config() const;
+	// asks the kernel where the mapped blocks really are, costs a system call per few thousand pages,
+	// made after the block list is copied so allocating threads do not wait on it
+	PlacementStats Stats() const;
+
+private:
+	struct Block
+	{
+		size_t bytes{};   // mapped length
+		bool explicitHuge{};
+	};
+
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	void* Map(size_t bytes, Block& outBlock);
+	void Unmap(void* p, const Block& block);
+
+	mutable std::mutex mutex;
+	PlacementConfig config;
+	std::map<void*, Block> blocks; // guarded by mutex, only large requests ever look here
+};
+
+namespace Memory
+{
+	PlacedResource* Placed(MemoryTag tag);
+	void SetPlacement(MemoryTag tag, const PlacementConfig& config);
+	PlacementStats Placement(MemoryTag tag);
+
+	// NUMA node of the calling thread, 0 where that cannot be told
+	unsigned CurrentNode();
+	unsigned NodeCount();
+	bool ParsePagePolicy(const char* name, PagePolicy& outPolicy);
+}
@@ -0,0 +1,24 @@
+#include "PreTradeRisk.h"
+
+void PreTradeRisk::SetLimits(AccountID account, const RiskLimits& limits)
+{
+	// accounts are dense ids handed out by the caller, growing here keeps checks a plain index
+	if (account >= accounts.size())
+		accounts.resize((size_t)account + 1);
+	accounts[account].limits = limits;
+	accounts[account].enabled = true;
+}
+
+const char* PreTradeRisk::RejectName(RiskReject reason)
+{
+	switch (reason)
+	{
+	case RiskReject::None: return "None";
+	case RiskReject::UnknownAccount: return "Unknown account";
+	case RiskReject::OrderSize: return "Order size";
+	case RiskReject::PriceBand: return "Price band";
+	case RiskReject::Credit: return "Credit";
+	case RiskReject::Position: return "Position";
+	default: return "Unknown";
+	}
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include "Memory.h"
+#include "Orders.h"
+#include <cstdint>
+#include <cstdlib>
+#include <memory_resource>
+
+enum class RiskReject : uint8_t
+{
+	None,
+	UnknownAccount, // SetLimits was never called for it
+	OrderSize,      // more than maxOrderQuantity in one order
+	PriceBand,      // further than priceBand ticks from the last trade
+	Credit,         // resting notional would pass maxOpenNotional
+	Position,       // position with every resting order filled would pass maxPosition
+	Count
+};
+
+struct RiskLimits
+{
+	static constexpr uint64_t NO_LIMIT = UINT64_MAX;
+
+	uint64_t maxOrderQuantity{ NO_LIMIT };
+	uint64_t priceBand{ NO_LIMIT };
+	uint64_t maxOpenNotional{ NO_LIMIT };
+	uint64_t maxPosition{ NO_LIMIT };
+};
+
+struct AccountExposure
+{
+	uint64_t openBuyQuantity{};
+	uint64_t openSellQuantity{};
+	uint64_t openNotional{};   // price * quantity of resting orders
+	int64_t position{};        // bought minus sold
+	uint64_t rejected{};
+	RiskReject lastReject{};
+};
+
+// Pre-trade limits and running exposure of every account, in one flat array indexed
+// by AccountID, so a check or an update is a single indexed access.
+// It belongs to an order book and is only touched under the book's lock.
+// Account 0 exists from the start without limits, for flow that does not carry an account.
+class PreTradeRisk
+{
+public:
+	PreTradeRisk() { accounts.resize(1); accounts[0].enabled = true; }
+
+	void SetLimits(AccountID account, const RiskLimits& limits);
+	// both are defaults for accounts that were never set up
+	RiskLimits Limits(AccountID account) const { return account < accounts.size() ? accounts[account].limits : RiskLimits{}; }
+	AccountExposure Exposure(AccountID account) const { return account < accounts.size() ? accounts[account].exposure : AccountExposure{}; }
+	size_t Accounts() const { return accounts.size(); }
+	uint64_t Rejects(RiskReject reason) const { return rejects[(size_t)reason]; }
+	static const char* RejectName(RiskReject reason);
+
+	// the band is measured from here, no band applies before the first trade
+	void SetReferencePrice(Price price) { referencePrice = price; hasReference = true; }
+
+	RiskReject Check(const Order& order)
+	{
+		if (order.account >= accounts.size() || accounts[order.account].enabled == false)
+			return Reject(RiskReject::UnknownAccount, nullptr);
+
+		Account& account = accounts[order.account];
+		const RiskLimits& limits = account.limits;
+		AccountExposure& exposure = account.exposure;
+		// an iceberg's reserve is exposure as much as what it shows
+		const uint64_t quantity = order.OpenQuantity();
+
+		if (quantity > limits.maxOrderQuantity)
+			return Reject(RiskReject::OrderSize, &exposure);
+
+		// market orders arrive priced at the far side of the book, so the band collars them too
+		if (hasReference && (uint64_t)std::abs((int64_t)order.price - referencePrice) > limits.priceBand)
+			return Reject(RiskReject::PriceBand, &exposure);
+
+		if (exposure.openNotional + Notional(order.price, quantity) > limits.maxOpenNotional)
+			return Reject(RiskReject::Credit, &exposure);
+
+		const int64_t worst = order.side == Side::Buy
+			? exposure.position + (int64_t)(exposure.openBuyQuantity + quantity)
+			: (int64_t)(exposure.openSellQuantity + quantity) - exposure.position;
+		if (worst > 0 && (uint64_t)worst > limits.maxPosition)
+			return Reject(RiskReject::Position, &exposure);
+
+		return RiskReject::None;
+	}
+
+	// order rests in the book with its whole open quantity
+	void OnAdded(const Order& order)
+	{
+		AccountExposure& exposure = accounts[order.account].exposure;
+		(order.side == Side::Buy ? exposure.openBuyQuantity : exposure.openSellQuantity) += order.OpenQuantity();
+		exposure.openNotional += Notional(order.price, order.OpenQuantity());
+	}
+
+	void OnFill(const Order& order, Quantity quantity)
+	{
+		AccountExposure& exposure = accounts[order.account].exposure;
+		(order.side == Side::Buy ? exposure.openBuyQuantity : exposure.openSellQuantity) -= quantity;
+		exposure.openNotional -= Notional(order.price, quantity);
+		exposure.position += order.side == Side::Buy ? (int64_t)quantity : -(int64_t)quantity;
+	}
+
+	// with what was still open when it left the book
+	void OnCancel(const Order& order)
+	{
+		AccountExposure& exposure = accounts[order.account].exposure;
+		(order.side == Side::Buy ? exposure.openBuyQuantity : exposure.openSellQuantity) -= order.OpenQuantity();
+		exposure.openNotional -= Notional(order.price, order.OpenQuantity());
+	}
+
+private:
+	struct Account
+	{
+		RiskLimits limits;
+		AccountExposure exposure;
+		bool enabled{};
+	};
+
+	static uint64_t Notional(Price price, uint64_t quantity) { return (uint64_t)std::abs((int64_t)price) * quantity; }
+
+	RiskReject Reject(RiskReject reason, AccountExposure* exposure)
+	{
+		++rejects[(size_t)reason];
+		if (exposure)
+		{
+			++exposure->rejected;
+			exposure->lastReject = reason;
+		}
+		return reason;
+	}
+
+	std::pmr::vector<Account> accounts{ Memory::Tracked(MemoryTag::OrderBook) };
+	uint64_t rejects[(size_t)RiskReject::Count]{};
+	Price referencePrice{};
+	bool hasReference{};
+};
@@ -0,0 +1,198 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+	constexpr size_t RING_SIZE = 8192;
+
+	// fields are relaxed atomics so a reader copying a slot the writer is reusing is not a data race,
+	// the reader finds out afterwards from the head and drops the slot
+	struct Slot
+	{
+		std::atomic<const char*> name{ nullptr };
+		std::atomic<uint64_t> start{};
+		std::atomic<uint64_t> end{};
+		std::atomic<uint64_t> allocatedBytes{};
+		std::atomic<uint32_t> depth{};
+		std::atomic<uint32_t> allocations{};
+	};
+
+	struct ThreadRing
+	{
+		std::atomic<uint64_t> head{}; // events written so far, slot is head % RING_SIZE
+		uint32_t depth{};             // open scopes, owner thread only
+
+		// registry mutex
+		bool inUse{ false };
+		uint64_t firstValid{};        // events before this belong to a thread that exited
+		std::string name;
+
+		Slot slots[RING_SIZE];
+	};
+
+	// rings are reused by later threads but never freed, so a snapshot can always read them
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<std::unique_ptr<ThreadRing>> rings;
+		uint32_t threadsSeen{};
+	};
+
+	Registry& GetRegistry()
+	{
+		// leaked on purpose, threads may still exit after static destruction started
+		static Registry* registry = new Registry;
+		return *registry;
+	}
+
+	struct RingOwner
+	{
+		ThreadRing* ring{ nullptr };
+
+		~RingOwner()
+		{
+			if (ring)
+			{
+				std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+				ring->inUse = false;
+			}
+		}
+	};
+
+	thread_local RingOwner owner;
+
+	std::atomic<bool> enabled{ true };
+
+	ThreadRing& CurrentRing()
+	{
+		if (owner.ring)
+			return *owner.ring;
+
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (std::unique_ptr<ThreadRing>& ring : registry.rings)
+		{
+			if (ring->inUse == false)
+			{
+				owner.ring = ring.get();
+				break;
+			}
+		}
+		if (owner.ring == nullptr)
+		{
+			registry.rings.push_back(std::make_unique<ThreadRing>());
+			owner.ring = registry.rings.back().get();
+		}
+
+		ThreadRing& ring = *owner.ring;
+		ring.inUse = true;
+		ring.firstValid = ring.head.load(std::memory_order_relaxed);
+		ring.depth = 0;
+		ring.name = "Thread " + std::to_string(++registry.threadsSeen);
+		return ring;
+	}
+}
+
+uint64_t Profiler::Now()
+{
+	static const auto epoch = std::chrono::steady_clock::now();
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::SetEnabled(bool _enabled)
+{
+	enabled.store(_enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::Enabled()
+{
+	return enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	ThreadRing& ring = CurrentRing();
+	std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+	ring.name = name;
+}
+
+void Profiler::Snapshot(uint64_t since, std::vector<ProfileThread>& outThreads)
+{
+	outThreads.clear();
+
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (const std::unique_ptr<ThreadRing>& ringPointer : registry.rings)
+	{
+		const ThreadRing& ring = *ringPointer;
+		const uint64_t head = ring.head.load(std::memory_order_acquire);
+		const uint64_t first = std::max(ring.firstValid, head > RING_SIZE ? head - RING_SIZE : 0);
+
+		ProfileThread thread;
+		thread.name = ring.name;
+		thread.events.reserve((size_t)(head - first));
+		for (uint64_t i = first; i < head; ++i)
+		{
+			const Slot& slot = ring.slots[i % RING_SIZE];
+			thread.events.push_back(ProfileEvent{
+				slot.name.load(std::memory_order_relaxed),
+				slot.start.load(std::memory_order_relaxed),
+				slot.end.load(std::memory_order_relaxed),
+				slot.depth.load(std::memory_order_relaxed),
+				slot.allocations.load(std::memory_order_relaxed),
+				slot.allocatedBytes.load(std::memory_order_relaxed) });
+		}
+
+		// the writer may be filling slot after % RING_SIZE by now, and everything it reused since head is gone
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t after = ring.head.load(std::memory_order_relaxed);
+		const uint64_t lapped = after >= RING_SIZE ? after - RING_SIZE + 1 : 0;
+		if (lapped > first)
+			thread.events.erase(thread.events.begin(), thread.events.begin() + (ptrdiff_t)std::min(lapped - first, head - first));
+
+		// scopes on one thread finish in order, so events are sorted by end
+		auto from = std::partition_point(thread.events.begin(), thread.events.end(), [since](const ProfileEvent& e) { return e.end < since; });
+		thread.events.erase(thread.events.begin(), from);
+
+		if (ring.inUse || thread.events.empty() == false)
+			outThreads.push_back(std::move(thread));
+	}
+}
+
+ProfileScope::ProfileScope(const char* _name)
+	: name{ _name }
+	, start{}
+	, allocations{}
+	, allocatedBytes{}
+	, active{ Profiler::Enabled() }
+{
+	if (active == false)
+		return;
+
+	++CurrentRing().depth;
+	allocations = Profiler::threadAllocations;
+	allocatedBytes = Profiler::threadAllocatedBytes;
+	start = Profiler::Now();
+}
+
+ProfileScope::~ProfileScope()
+{
+	if (active == false)
+		return;
+
+	const uint64_t end = Profiler::Now();
+	ThreadRing& ring = *owner.ring;
+	const uint64_t index = ring.head.load(std::memory_order_relaxed);
+	Slot& slot = ring.slots[index % RING_SIZE];
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.start.store(start, std::memory_order_relaxed);
+	slot.end.store(end, std::memory_order_relaxed);
+	slot.depth.store(--ring.depth, std::memory_order_relaxed);
+	slot.allocations.store((uint32_t)(Profiler::threadAllocations - allocations), std::memory_order_relaxed);
+	slot.allocatedBytes.store(Profiler::threadAllocatedBytes - allocatedBytes, std::memory_order_relaxed);
+	ring.head.store(index + 1, std::memory_order_release);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One finished scope, copied out of a thread's ring.
+struct ProfileEvent
+{
+	const char* name;
+	uint64_t start; // ns since the profiler started
+	uint64_t end;
+	uint32_t depth; // 0 for scopes with no enclosing scope on their thread
+	uint32_t allocations; // operator new calls on this thread while the scope was open, children included
+	uint64_t allocatedBytes;
+};
+
+struct ProfileThread
+{
+	std::string name;
+	std::vector<ProfileEvent> events; // ordered by end time
+};
+
+// Scoped CPU timers collected into a fixed ring per thread.
+// Writers never lock: each thread only appends to its own ring and publishes the new head,
+// a reader copies the rings and drops whatever the writer lapped while it was copying.
+namespace Profiler
+{
+	uint64_t Now();
+
+	void SetEnabled(bool enabled);
+	bool Enabled();
+
+	// label for the calling thread's row in the timeline
+	void SetThreadName(const char* name);
+
+	// copies the events of every thread that ended at or after since
+	void Snapshot(uint64_t since, std::vector<ProfileThread>& outThreads);
+
+	// operator new calls and bytes on the calling thread so far, counted in ProfilerAllocations.cpp
+	extern thread_local uint64_t threadAllocations;
+	extern thread_local uint64_t threadAllocatedBytes;
+}
+
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* _name);
+	~ProfileScope();
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* name;
+	uint64_t start;
+	uint64_t allocations;
+	uint64_t allocatedBytes;
+	bool active;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// name must outlive the profiler, in practice a string literal
+#ifdef TRADING_NO_PROFILE
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+#else
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#endif
@@ -0,0 +1,39 @@
+#include "Profiler.h"
+#include <cstdlib>
+#include <new>
+
+// The global allocation replacements live apart from the profiler itself, where
+// they would be inlined next to its own new/delete pairs and confuse the compiler's
+// mismatched new/delete checks.
+thread_local uint64_t Profiler::threadAllocations = 0;
+thread_local uint64_t Profiler::threadAllocatedBytes = 0;
+
+#ifndef TRADING_NO_PROFILE
+// counts every allocation per thread so scopes can report what they allocated,
+// the array and nothrow forms end up here through their default definitions
+void* operator new(std::size_t size)
+{
+	++Profiler::threadAllocations;
+	Profiler::threadAllocatedBytes += size;
+
+	for (;;)
+	{
+		if (void* memory = std::malloc(size ? size : 1))
+			return memory;
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+#endif
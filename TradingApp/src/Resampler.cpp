@@ -0,0 +1,96 @@
+#include "Resampler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	constexpr double SECONDS_PER_DAY = 60 * 60 * 24;
+}
+
+void ResampledLevel::Update(const DataStore& source)
+{
+	if (bars.name.empty())
+		bars.name = source.name;
+
+	const size_t count = source.size();
+	if (rewrites != source.rewrites)
+	{
+		rewrites = source.rewrites;
+		if (consumed > 0 && consumed <= count)
+		{
+			// the newest row consumed was overwritten, fold the newest bar again from its first row
+			const size_t last = bars.size() - 1;
+			DataFrame bar{};
+			bar.date = bars.date[last];
+			bar.open = source.open[barStart];
+			bar.high = source.high[barStart];
+			bar.low = source.low[barStart];
+			bar.close = source.close[consumed - 1];
+			bar.volume = 0.0;
+			for (size_t i = barStart; i < consumed; ++i)
+			{
+				bar.high = std::max(source.high[i], bar.high);
+				bar.low = std::min(source.low[i], bar.low);
+				bar.volume += source.volume[i];
+			}
+			bars.UpdateLast(bar);
+		}
+	}
+
+	for (size_t i = consumed; i < count; ++i)
+	{
+		const int64_t key = BucketKey(source.date[i], i);
+
+		if (bars.size() == 0 || key != currentKey)
+		{
+			DataFrame bar{};
+			bar.date = source.date[i];
+			bar.open = source.open[i];
+			bar.high = source.high[i];
+			bar.low = source.low[i];
+			bar.close = source.close[i];
+			bar.volume = source.volume[i];
+			bars.PushData(bar);
+			barStart = i;
+			currentKey = key;
+			continue;
+		}
+
+		const size_t last = bars.size() - 1;
+		DataFrame bar{};
+		bar.date = bars.date[last];
+		bar.open = bars.open[last];
+		bar.high = std::max(bars.high[last], source.high[i]);
+		bar.low = std::min(bars.low[last], source.low[i]);
+		bar.close = source.close[i];
+		bar.volume = bars.volume[last] + source.volume[i];
+		bars.UpdateLast(bar);
+	}
+	consumed = count;
+}
+
+int64_t ResampledLevel::BucketKey(double date, size_t row) const
+{
+	const int64_t days = (int64_t)std::floor(date / SECONDS_PER_DAY);
+
+	switch (spec.interval)
+	{
+	case BarInterval::Weekly:
+	{
+		// 1970-01-01 was a thursday, shift so weeks start on monday
+		const int64_t shifted = days + 3;
+		return shifted >= 0 ? shifted / 7 : (shifted - 6) / 7;
+	}
+	case BarInterval::Monthly:
+	{
+		const std::chrono::year_month_day ymd{ std::chrono::sys_days{ std::chrono::days{ days } } };
+		return (int64_t)(int)ymd.year() * 12 + (unsigned)ymd.month();
+	}
+	case BarInterval::Bars:
+		return (int64_t)(row / std::max<uint32_t>(spec.count, 1));
+	default:
+		break;
+	}
+	return 0;
+}
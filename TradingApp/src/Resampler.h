@@ -0,0 +1,44 @@
+#pragma once
+#include "DataStore.h"
+#include <cstdint>
+
+enum class BarInterval
+{
+	Weekly,   // monday to sunday
+	Monthly,  // calendar month
+	Bars      // every N source rows
+};
+
+struct ResampleSpec
+{
+	BarInterval interval{ BarInterval::Weekly };
+	uint32_t count{ 1 }; // rows per bar for BarInterval::Bars
+
+	bool operator==(const ResampleSpec& other) const = default;
+};
+
+// Coarser OHLCV bars derived from a DataStore in one linear pass.
+// Update only consumes rows appended since the previous call; the newest bar
+// keeps absorbing rows until one falls into the next bucket. When the source's
+// newest row was rewritten in place, under the same date, the newest bar is
+// folded again from its rows.
+class ResampledLevel
+{
+public:
+	explicit ResampledLevel(ResampleSpec _spec) : spec{ _spec } {}
+
+	void Update(const DataStore& source);
+
+	const ResampleSpec& Spec() const { return spec; }
+	const DataStore& Bars() const { return bars; }
+
+private:
+	int64_t BucketKey(double date, size_t row) const;
+
+	ResampleSpec spec;
+	DataStore bars;
+	size_t consumed{};
+	size_t barStart{};   // source row the newest bar begins at
+	uint64_t rewrites{}; // source.rewrites when consumed was last advanced
+	int64_t currentKey{};
+};
@@ -0,0 +1,295 @@
+#include "Screener.h"
+#include "Cpu.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#define SCREENER_AVX2 CPU_X64
+
+void DateIndex::Build(const MarketData& data)
+{
+	PROFILE_SCOPE("DateIndex::Build");
+	symbols = data.Count();
+
+	dates.clear();
+	for (const DataStore& ds : data.Stores())
+		dates.insert(dates.end(), ds.date.begin(), ds.date.end());
+	std::sort(dates.begin(), dates.end());
+	dates.erase(std::unique(dates.begin(), dates.end()), dates.end());
+
+	days.clear();
+	days.reserve(dates.size());
+	for (size_t day = 0; day < dates.size(); ++day)
+		days.emplace((int64_t)dates[day], (uint32_t)day);
+
+	// both sides are sorted, so each symbol is one merge-like walk along the shared axis
+	rows.assign(dates.size() * symbols, NO_ROW);
+	for (size_t s = 0; s < symbols; ++s)
+	{
+		const DataStore& ds = data.Get((SymbolID)s);
+		if (ds.IsCompressed())
+			continue;
+		const double* day = dates.data();
+		const double* lastDay = dates.data() + dates.size();
+		for (size_t row = 0; row < ds.size(); ++row)
+		{
+			day = std::lower_bound(day, lastDay, ds.date[row]);
+			rows[(day - dates.data()) * symbols + s] = (int32_t)row;
+		}
+	}
+}
+
+size_t DateIndex::Day(double date) const
+{
+	auto found = days.find((int64_t)date);
+	return found == days.end() ? NO_DAY : found->second;
+}
+
+int32_t DateIndex::Row(SymbolID symbol, double date) const
+{
+	const size_t day = Day(date);
+	return day == NO_DAY || symbol >= symbols ? NO_ROW : Row(symbol, day);
+}
+
+namespace
+{
+	constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+	// one value per symbol, reused for every day a worker screens
+	struct Scratch
+	{
+		std::vector<double> numerator;
+		std::vector<double> denominator;
+		std::vector<double> values;
+		std::vector<double> sortValues;
+		std::vector<uint8_t> pass;
+	};
+
+	// lowest low and highest high over rows [first, last), through the block extents when they are current
+	void WindowExtent(const DataStore& ds, size_t first, size_t last, double& outLow, double& outHigh)
+	{
+		if (ds.HasExtents())
+		{
+			ds.RangeExtent(first, last, outLow, outHigh);
+			return;
+		}
+		outLow = *std::min_element(ds.low.begin() + first, ds.low.begin() + last);
+		outHigh = *std::max_element(ds.high.begin() + first, ds.high.begin() + last);
+	}
+
+	// the two inputs of field for every symbol on the day; rows live in separate columns,
+	// so this is the one scalar stage, everything after it runs over packed arrays
+	void Gather(const MarketData& data, const int32_t* dayRows, size_t count, ScreenField field, uint32_t lookback, double* outNumerator, double* outDenominator)
+	{
+		for (size_t s = 0; s < count; ++s)
+		{
+			const DataStore& ds = data.Get((SymbolID)s);
+			const int32_t row = dayRows[s];
+			double numerator = NaN, denominator = NaN;
+			if (row != DateIndex::NO_ROW && (size_t)row < ds.size())
+			{
+				const double previousClose = row > 0 ? ds.close[row - 1] : NaN;
+				switch (field)
+				{
+				case ScreenField::Change: numerator = ds.close[row]; denominator = previousClose; break;
+				case ScreenField::Gap: numerator = ds.open[row]; denominator = previousClose; break;
+				case ScreenField::Range: numerator = ds.high[row]; denominator = ds.low[row]; break;
+				case ScreenField::Close: numerator = ds.close[row]; break;
+				case ScreenField::Volume: numerator = ds.volume[row]; break;
+				case ScreenField::VsHigh:
+				case ScreenField::VsLow:
+					if ((size_t)row >= lookback && lookback > 0)
+					{
+						double low, high;
+						WindowExtent(ds, row - lookback, row, low, high);
+						numerator = ds.close[row];
+						denominator = field == ScreenField::VsHigh ? high : low;
+					}
+					break;
+				default: break;
+				}
+			}
+			outNumerator[s] = numerator;
+			outDenominator[s] = denominator;
+		}
+	}
+
+#if SCREENER_AVX2
+	// vector halves of Finish and Compare, each returns the first symbol it left to the scalar loop
+
+	AVX2_TARGET size_t RatioAvx2(const double* numerator, const double* denominator, size_t count, double* out)
+	{
+		size_t i = 0;
+		const __m256d one = _mm256_set1_pd(1.0);
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m256d quotient = _mm256_div_pd(_mm256_loadu_pd(numerator + i), _mm256_loadu_pd(denominator + i));
+			_mm256_storeu_pd(out + i, _mm256_sub_pd(quotient, one));
+		}
+		return i;
+	}
+
+	AVX2_TARGET size_t CompareAvx2(const double* values, size_t count, ScreenCompare compare, double threshold, uint8_t* pass)
+	{
+		size_t i = 0;
+		const __m256d limit = _mm256_set1_pd(threshold);
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m256d v = _mm256_loadu_pd(values + i);
+			const __m256d hit = compare == ScreenCompare::Above ? _mm256_cmp_pd(v, limit, _CMP_GT_OQ) : _mm256_cmp_pd(v, limit, _CMP_LT_OQ);
+			const int bits = _mm256_movemask_pd(hit);
+			for (size_t k = 0; k < 4; ++k)
+				pass[i + k] &= (uint8_t)((bits >> k) & 1);
+		}
+		return i;
+	}
+#endif
+
+	// out[i] = numerator[i] / denominator[i] - 1 for ratios, numerator[i] otherwise
+	void Finish(const double* numerator, const double* denominator, size_t count, bool ratio, double* out)
+	{
+		if (ratio == false)
+		{
+			std::copy(numerator, numerator + count, out);
+			return;
+		}
+
+		size_t i = 0;
+#if SCREENER_AVX2
+		if (Cpu::HasAvx2())
+			i = RatioAvx2(numerator, denominator, count, out);
+#endif
+		for (; i < count; ++i)
+		{
+			out[i] = numerator[i] / denominator[i] - 1.0;
+		}
+	}
+
+	// clears pass[i] where values[i] fails the comparison, NaN always fails
+	void Compare(const double* values, size_t count, ScreenCompare compare, double threshold, uint8_t* pass)
+	{
+		size_t i = 0;
+#if SCREENER_AVX2
+		if (Cpu::HasAvx2())
+			i = CompareAvx2(values, count, compare, threshold, pass);
+#endif
+		for (; i < count; ++i)
+		{
+			const bool hit = compare == ScreenCompare::Above ? values[i] > threshold : values[i] < threshold;
+			pass[i] &= (uint8_t)hit;
+		}
+	}
+
+	void Evaluate(const MarketData& data, const int32_t* dayRows, size_t count, ScreenField field, uint32_t lookback, Scratch& scratch, double* out)
+	{
+		Gather(data, dayRows, count, field, lookback, scratch.numerator.data(), scratch.denominator.data());
+		Finish(scratch.numerator.data(), scratch.denominator.data(), count, Screener::IsRatio(field), out);
+	}
+
+	void ScreenDay(const MarketData& data, const DateIndex& index, size_t day, const ScreenQuery& query, Scratch& scratch, std::vector<ScreenHit>& out)
+	{
+		// symbols added since the index was built have no rows in it yet
+		const size_t count = std::min(index.Symbols(), data.Count());
+		const int32_t* dayRows = index.DayRows(day);
+		scratch.numerator.resize(count);
+		scratch.denominator.resize(count);
+		scratch.values.resize(count);
+		scratch.sortValues.resize(count);
+		scratch.pass.assign(count, 1);
+
+		for (const ScreenCondition& condition : query.conditions)
+		{
+			Evaluate(data, dayRows, count, condition.field, condition.lookback, scratch, scratch.values.data());
+			Compare(scratch.values.data(), count, condition.compare, condition.threshold, scratch.pass.data());
+		}
+		Evaluate(data, dayRows, count, query.sortBy, query.sortLookback, scratch, scratch.sortValues.data());
+
+		// a NaN sort value means the symbol has no row, or too little history, to rank it by
+		const size_t first = out.size();
+		for (size_t s = 0; s < count; ++s)
+		{
+			if (scratch.pass[s] && std::isnan(scratch.sortValues[s]) == false)
+				out.push_back(ScreenHit{ (SymbolID)s, (uint32_t)day, scratch.sortValues[s] });
+		}
+
+		auto better = [&query](const ScreenHit& a, const ScreenHit& b) { return query.descending ? a.value > b.value : a.value < b.value; };
+		const size_t hits = out.size() - first;
+		const size_t keep = query.limit ? std::min(query.limit, hits) : hits;
+		std::partial_sort(out.begin() + first, out.begin() + first + keep, out.end(), better);
+		out.resize(first + keep);
+	}
+}
+
+namespace Screener
+{
+	std::vector<ScreenHit> Run(const MarketData& data, const DateIndex& index, size_t day, const ScreenQuery& query)
+	{
+		PROFILE_SCOPE("Screener::Run");
+		std::vector<ScreenHit> hits;
+		if (day >= index.Days())
+			return hits;
+
+		Scratch scratch;
+		ScreenDay(data, index, day, query, scratch, hits);
+		return hits;
+	}
+
+	std::vector<ScreenHit> RunRange(const MarketData& data, const DateIndex& index, size_t firstDay, size_t lastDay, const ScreenQuery& query, unsigned numThreads)
+	{
+		PROFILE_SCOPE("Screener::RunRange");
+		lastDay = std::min(lastDay, index.Days());
+		if (firstDay >= lastDay)
+			return {};
+
+		if (numThreads == 0)
+			numThreads = std::max(1u, std::thread::hardware_concurrency());
+		numThreads = (unsigned)std::min<size_t>(numThreads, lastDay - firstDay);
+
+		// contiguous runs of days per worker, so concatenating keeps the hits in day order
+		std::vector<std::vector<ScreenHit>> parts(numThreads);
+		{
+			std::vector<std::jthread> workers;
+			workers.reserve(numThreads);
+			const size_t perThread = (lastDay - firstDay + numThreads - 1) / numThreads;
+			for (unsigned t = 0; t < numThreads; ++t)
+			{
+				workers.emplace_back([&, t] {
+					PROFILE_THREAD("Screener worker");
+					PROFILE_SCOPE("Screener::Days");
+					Scratch scratch;
+					const size_t begin = firstDay + t * perThread;
+					const size_t end = std::min(begin + perThread, lastDay);
+					for (size_t day = begin; day < end; ++day)
+						ScreenDay(data, index, day, query, scratch, parts[t]);
+				});
+			}
+		}
+
+		std::vector<ScreenHit> hits;
+		for (const std::vector<ScreenHit>& part : parts)
+			hits.insert(hits.end(), part.begin(), part.end());
+		return hits;
+	}
+
+	const char* FieldName(ScreenField field)
+	{
+		switch (field)
+		{
+		case ScreenField::Change: return "Change";
+		case ScreenField::Gap: return "Gap";
+		case ScreenField::Range: return "Range";
+		case ScreenField::Close: return "Close";
+		case ScreenField::Volume: return "Volume";
+		case ScreenField::VsHigh: return "Vs high";
+		case ScreenField::VsLow: return "Vs low";
+		default: return "Unknown";
+		}
+	}
+
+	bool IsRatio(ScreenField field)
+	{
+		return field != ScreenField::Close && field != ScreenField::Volume;
+	}
+}
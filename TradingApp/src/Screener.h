@@ -0,0 +1,92 @@
+#pragma once
+#include "MarketData.h"
+#include "Memory.h"
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+// Every date any symbol has a row on, and each symbol's row for each of them.
+// Rows are stored day-major, so all symbols of one day sit next to each other
+// and (symbol, date) is a hash lookup plus an index.
+// Compressed symbols are left out and have no rows here until they are decompressed.
+class DateIndex
+{
+public:
+	static constexpr int32_t NO_ROW = -1;
+	static constexpr size_t NO_DAY = SIZE_MAX;
+
+	void Build(const MarketData& data);
+
+	size_t Days() const { return dates.size(); }
+	size_t Symbols() const { return symbols; }
+	const std::vector<double>& Dates() const { return dates; }
+
+	// index into Dates(), NO_DAY when no symbol traded then
+	size_t Day(double date) const;
+	// symbol's row on that day, NO_ROW when it has none
+	int32_t Row(SymbolID symbol, size_t day) const { return rows[day * symbols + symbol]; }
+	int32_t Row(SymbolID symbol, double date) const;
+	// rows of every symbol on that day, indexed by SymbolID
+	const int32_t* DayRows(size_t day) const { return rows.data() + day * symbols; }
+
+private:
+	size_t symbols{};
+	std::vector<double> dates;
+	std::unordered_map<int64_t, uint32_t> days; // date in whole seconds to day
+	std::pmr::vector<int32_t> rows{ Memory::Tracked(MemoryTag::MarketData) };
+};
+
+enum class ScreenField
+{
+	Change, // close over the previous row's close, minus one
+	Gap,    // open over the previous row's close, minus one
+	Range,  // high over low, minus one
+	Close,
+	Volume,
+	VsHigh, // close over the highest high of the lookback rows before, minus one
+	VsLow,  // close over the lowest low of the lookback rows before, minus one
+	Count
+};
+
+enum class ScreenCompare
+{
+	Above,
+	Below
+};
+
+struct ScreenCondition
+{
+	ScreenField field{ ScreenField::Change };
+	ScreenCompare compare{ ScreenCompare::Above };
+	double threshold{};
+	uint32_t lookback{ 200 }; // rows, VsHigh and VsLow only
+};
+
+struct ScreenQuery
+{
+	std::vector<ScreenCondition> conditions; // all of them have to hold
+	ScreenField sortBy{ ScreenField::Change };
+	uint32_t sortLookback{ 200 };
+	bool descending{ true };
+	size_t limit{ 50 };                      // hits kept per day, 0 keeps all
+};
+
+struct ScreenHit
+{
+	SymbolID symbol{};
+	uint32_t day{};
+	double value{};                          // of the sort field
+};
+
+namespace Screener
+{
+	// symbols passing every condition on the day, best first
+	std::vector<ScreenHit> Run(const MarketData& data, const DateIndex& index, size_t day, const ScreenQuery& query);
+	// the same for each day in [firstDay, lastDay), days split across worker threads, hits in day order
+	std::vector<ScreenHit> RunRange(const MarketData& data, const DateIndex& index, size_t firstDay, size_t lastDay, const ScreenQuery& query, unsigned numThreads = 0);
+
+	const char* FieldName(ScreenField field);
+	// fields that are a ratio minus one, shown as percentages
+	bool IsRatio(ScreenField field);
+}
@@ -0,0 +1,107 @@
+#include "TaskPool.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// remaining tasks [begin, end) of one worker, padded so workers do not share cache lines
+	struct alignas(64) TaskRange
+	{
+		std::mutex mutex;
+		// only changed under mutex, atomic so thieves can peek at the size without it
+		std::atomic<size_t> begin{};
+		std::atomic<size_t> end{};
+
+		size_t Left() const
+		{
+			const size_t b = begin.load(std::memory_order_relaxed);
+			const size_t e = end.load(std::memory_order_relaxed);
+			return e > b ? e - b : 0;
+		}
+	};
+
+	bool TakeOwn(TaskRange& range, size_t& outTask)
+	{
+		std::lock_guard<std::mutex> lock(range.mutex);
+		if (range.begin >= range.end)
+			return false;
+		outTask = range.begin++;
+		return true;
+	}
+
+	// moves the back half of the fullest other range into own, false once nothing is left
+	bool Steal(std::vector<TaskRange>& ranges, unsigned self)
+	{
+		for (;;)
+		{
+			unsigned victim = self;
+			size_t most = 0;
+			for (unsigned i = 0; i < ranges.size(); ++i)
+			{
+				const size_t left = ranges[i].Left();
+				if (i != self && left > most)
+				{
+					most = left;
+					victim = i;
+				}
+			}
+			if (victim == self)
+				return false;
+
+			size_t begin, end;
+			{
+				std::lock_guard<std::mutex> lock(ranges[victim].mutex);
+				TaskRange& range = ranges[victim];
+				if (range.Left() == 0)
+					continue;
+				begin = range.begin + range.Left() / 2;
+				end = range.end;
+				range.end = begin;
+			}
+
+			std::lock_guard<std::mutex> lock(ranges[self].mutex);
+			ranges[self].begin = begin;
+			ranges[self].end = end;
+			return true;
+		}
+	}
+}
+
+void RunTasks(size_t count, unsigned numThreads, const std::function<void(size_t task, unsigned worker)>& fn)
+{
+	if (count == 0)
+		return;
+
+	if (numThreads == 0)
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	numThreads = (unsigned)std::min<size_t>(numThreads, count);
+
+	std::vector<TaskRange> ranges(numThreads);
+	for (unsigned i = 0; i < numThreads; ++i)
+	{
+		ranges[i].begin = count * i / numThreads;
+		ranges[i].end = count * (i + 1) / numThreads;
+	}
+
+	std::vector<std::jthread> workers;
+	workers.reserve(numThreads);
+	for (unsigned i = 0; i < numThreads; ++i)
+	{
+		workers.emplace_back([&ranges, &fn, i] {
+			PROFILE_THREAD("Task worker");
+			size_t task;
+			do
+			{
+				while (TakeOwn(ranges[i], task))
+				{
+					fn(task, i);
+				}
+			} while (Steal(ranges, i));
+		});
+	}
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+// Runs fn(task, worker) for every task in [0, count) on numThreads workers (0 uses every
+// hardware thread). Each worker starts on an even slice of the range and works it front to
+// back; once its slice is empty it steals the back half of the largest remaining slice,
+// so tasks of very different cost still keep every worker busy until the end.
+void RunTasks(size_t count, unsigned numThreads, const std::function<void(size_t task, unsigned worker)>& fn);
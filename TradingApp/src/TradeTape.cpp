@@ -0,0 +1,93 @@
+#include "TradeTape.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+TradeTape::TradeTape(const std::vector<double>& barSeconds)
+{
+	levels.resize(barSeconds.size());
+	for (size_t i = 0; i < barSeconds.size(); ++i)
+	{
+		levels[i].seconds = std::max(barSeconds[i], 0.001);
+		char name[32];
+		std::snprintf(name, sizeof(name), "Tape %gs", levels[i].seconds);
+		levels[i].bars.name = name;
+	}
+}
+
+void TradeTape::Append(double time, Price price, Quantity quantity, Side aggressor)
+{
+	const size_t row = count % CHUNK_ROWS;
+	if (row == 0)
+		chunks.emplace_back();
+
+	Chunk& chunk = chunks.back();
+	chunk.time[row] = time;
+	chunk.price[row] = price;
+	chunk.quantity[row] = quantity;
+	chunk.aggressor[row] = aggressor;
+	++count;
+	(aggressor == Side::Buy ? buyVolume : sellVolume) += quantity;
+
+	for (BarLevel& level : levels)
+		Roll(level, time, price, quantity);
+}
+
+void TradeTape::Append(double time, const Trades& trades, Side aggressor)
+{
+	PROFILE_SCOPE("TradeTape::Append");
+	for (const Trade& trade : trades)
+	{
+		const TradeInfo& resting = aggressor == Side::Buy ? trade.askTrade : trade.bidTrade;
+		Append(time, resting.price, resting.quantity, aggressor);
+	}
+}
+
+void TradeTape::Roll(BarLevel& level, double time, Price price, Quantity quantity)
+{
+	const int64_t bucket = (int64_t)std::floor(time / level.seconds);
+	DataStore& bars = level.bars;
+
+	// a fill stamped before the newest bar, clocks of different machines, lands in it
+	if (bars.size() == 0 || bucket > level.bucket)
+	{
+		DataFrame bar;
+		bar.date = bucket * level.seconds;
+		bar.open = bar.close = bar.high = bar.low = price;
+		bar.volume = quantity;
+		bars.PushData(bar);
+		level.bucket = bucket;
+		return;
+	}
+
+	const size_t last = bars.size() - 1;
+	DataFrame bar;
+	bar.date = bars.date[last];
+	bar.open = bars.open[last];
+	bar.close = price;
+	bar.high = std::max(bars.high[last], (double)price);
+	bar.low = std::min(bars.low[last], (double)price);
+	bar.volume = bars.volume[last] + quantity;
+	bars.UpdateLast(bar);
+}
+
+size_t TradeTape::ChunkRows(size_t index) const
+{
+	return std::min(CHUNK_ROWS, count - index * CHUNK_ROWS);
+}
+
+void TradeTape::Clear()
+{
+	chunks.clear();
+	count = 0;
+	buyVolume = 0;
+	sellVolume = 0;
+	for (BarLevel& level : levels)
+	{
+		std::string name = std::move(level.bars.name);
+		level.bars = DataStore{};
+		level.bars.name = std::move(name);
+		level.bucket = 0;
+	}
+}
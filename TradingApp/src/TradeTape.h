@@ -0,0 +1,65 @@
+#pragma once
+#include "DataStore.h"
+#include "Memory.h"
+#include "Orderbook.h"
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <vector>
+
+// Time and sales. Every fill is appended to columns split into fixed size chunks,
+// so growing the tape never moves what is already recorded, and rolled into OHLCV
+// bars at each configured interval as it arrives. Bars are plain DataStores that
+// the candlestick plots and indicators read like loaded history.
+// Append is O(intervals); it allocates once per CHUNK_ROWS trades and when a bar
+// column grows, never per trade, and bar queries never go back to the tape.
+class TradeTape
+{
+public:
+	static constexpr size_t CHUNK_ROWS = 4096;
+
+	struct Chunk
+	{
+		double time[CHUNK_ROWS];   // seconds since the unix epoch
+		Price price[CHUNK_ROWS];
+		Quantity quantity[CHUNK_ROWS];
+		Side aggressor[CHUNK_ROWS];
+	};
+
+	explicit TradeTape(const std::vector<double>& barSeconds = { 1.0, 10.0, 60.0 });
+
+	void Append(double time, Price price, Quantity quantity, Side aggressor);
+	// fills of one incoming order on the aggressor side, priced at the resting orders
+	void Append(double time, const Trades& trades, Side aggressor);
+
+	size_t Size() const { return count; }
+	size_t Chunks() const { return chunks.size(); }
+	// rows [index * CHUNK_ROWS, min(Size(), (index + 1) * CHUNK_ROWS))
+	const Chunk& GetChunk(size_t index) const { return chunks[index]; }
+	size_t ChunkRows(size_t index) const;
+
+	uint64_t Volume(Side aggressor) const { return aggressor == Side::Buy ? buyVolume : sellVolume; }
+
+	size_t Intervals() const { return levels.size(); }
+	double IntervalSeconds(size_t interval) const { return levels[interval].seconds; }
+	// the newest bar is still forming
+	const DataStore& Bars(size_t interval) const { return levels[interval].bars; }
+
+	void Clear();
+
+private:
+	struct BarLevel
+	{
+		double seconds{};
+		int64_t bucket{};   // time / seconds of the newest bar
+		DataStore bars;
+	};
+
+	void Roll(BarLevel& level, double time, Price price, Quantity quantity);
+
+	std::pmr::deque<Chunk> chunks{ Memory::Tracked(MemoryTag::TradeTape) };
+	size_t count{};
+	uint64_t buyVolume{};
+	uint64_t sellVolume{};
+	std::vector<BarLevel> levels;
+};
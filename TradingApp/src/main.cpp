@@ -2,13 +2,11 @@
 #include <memory>
 #include "App.h"
 
-int main(int argc, const char* argv)
+int main(int argc, char** argv)
 {
-	(void)argc;
-	(void)argv;
-
 	std::unique_ptr<App> app = std::make_unique<App>();
-	
+	app->ParseArgs(argc, argv);
+
 	app->Run();
 
 	return 0;